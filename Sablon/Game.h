@@ -6,6 +6,9 @@
 #include <GLFW/glfw3.h>
 
 #include "game_object.h"
+#include "render_queue.h"
+#include "render_cull.h"
+#include "camera_2d.h"
 
 enum GameState {
     GAME_ACTIVE,
@@ -13,39 +16,105 @@ enum GameState {
     GAME_WIN
 };
 
+// layer bits the scene objects are filed under for spatial queries
+enum SceneLayer {
+    LAYER_BACKGROUND = 1 << 0,
+    LAYER_CELESTIAL  = 1 << 1,
+    LAYER_PYRAMIDS   = 1 << 2,
+    LAYER_DOORS      = 1 << 3,
+    LAYER_WATER      = 1 << 4,
+    LAYER_FISH       = 1 << 5,
+    LAYER_GRASS      = 1 << 6,
+    LAYER_ALL        = 0x7F
+};
+
 class Game
 {
 public:
     GameState               State;
     bool                    Keys[1024];
     unsigned int            Width, Height;
+    // scene sizes, raise these to stress the per-entity loops
+    unsigned int            StarCount = 50;
+    unsigned int            PyramidCount = 3;
+    unsigned int            GrassCount = 30;
+    unsigned int            ParticleCount = 20000;
+    // streamed desert chunks are kept this many chunks beyond the view, within the budget in bytes
+    int                     ChunkRadius = 1;
+    size_t                  ChunkBudget = 16u << 20;
+    // take streamed chunks in on fixed frames instead of whenever the workers finish them,
+    // so recorded and replayed runs see the same scene on the same frames
+    bool                    DeterministicStreaming = false;
+    // simulate particles in a compute shader when the context supports one
+    bool                    ComputeParticles = true;
+    // draw the scene at a fraction of the window resolution, between these bounds, chosen so
+    // the GPU keeps up with the target frame time; text is always drawn at full resolution
+    bool                    DynamicResolution = false;
+    float                   MinResolutionScale = 0.5f;
+    float                   MaxResolutionScale = 1.0f;
+    float                   TargetFrameTime = 1.0f / 60.0f;
+    // every random stream is derived from this, so one seed always builds the same scene
+    unsigned long long      Seed = 0;
+    // when set, the sprite and text draws of every frame are written to this file
+    const char*             TracePath = nullptr;
+    // what culling dropped from the last recorded frame
+    CullStats               Culled{};
+    // what is drawn, culled against and clicked on
+    Camera2D                Camera;
     Game(unsigned int width, unsigned int height);
     Game();
     ~Game();
     void Init();
     void ProcessInput(int key);
+    // x and y are in window pixels
     void ProcessMouseClick(double x, double y);
+    // the framebuffer changed size; the next recorded frame projects the world onto the new one
+    void Resize(int width, int height);
     void Update(float dt);
+    // false while nothing drawn changed since the last Render(), so the frame can be skipped
+    bool NeedsRedraw() const;
+    // true while the only change is the fish, sand and stars animating with time paused
+    bool AmbientOnly() const;
+    // the window has to be drawn again, e.g. after it was uncovered
+    void Invalidate();
     bool Render();
+    // Render() into a command buffer instead of GL, and replay such a buffer on the GL thread
+    bool Record(CommandBuffer& commands);
+    void Execute(const CommandBuffer& commands);
 private:
     bool _shouldClose = false;
+    bool _printCullStats = false;
+    // set by whatever changes the picture, cleared when a frame is drawn; the update tasks
+    // each report into their own flag so they never write the same memory
+    bool _redraw = true;
+    bool _ambientRedraw = false;
+    bool _cameraMoved = false;
+    bool _doorsOpening = false;
     bool _startOpeningDoors;
     bool _isDisplayedToBeContinued = false;
     float _toBeContinuedThreshold = 0.0f;
-    void _openDoors(float dt);
+    bool _openDoors(float dt);
     void _initializeDoors() const;
     void _toggleDoorVisibility();
     float _sunAngle = 180.0f;
     float _timeSpeed = 50.0f;
+    float _frameTime = 0.0f;
+    void _buildUpdateTasks();
+    void _drawAll(const std::vector<GameObject*>& objects) const;
+    void _drawLayer(unsigned int layer, const SpriteCommand* sprites, size_t count) const;
     void _updateSunAndMoon(float dt);
-    void _updateSkyBrightness(float dt) const;
+    float _daylight = 0.0f;
+    float _skyTime = 0.0f;
+    void _updateSkyBrightness(float dt);
     float _getSunRiseHeightPoint() const;
     float _getSunRotationRadius() const;
     GameObject* GetLargestPyramid() const;
-    void _initializeStars() const;
+    void _initializeStars();
+    void _initializeParticles();
     void _initializePyramids();
-    void _initializeGrass() const;
+    void _initializeGrass();
     void _moveFish(float dt);
+    void _moveCamera(float dt);
     void _toggleGrassVisibility();
 };
 
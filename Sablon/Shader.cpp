@@ -1,6 +1,16 @@
 #include "Shader.h"
 #include <iostream>
 
+namespace
+{
+    // drivers may only keep what glGetProgramBinary needs when asked before linking
+    void allowProgramBinary(unsigned int program)
+    {
+        if (GLEW_ARB_get_program_binary)
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
 Shader& Shader::Use()
 {
     glUseProgram(this->ID);
@@ -9,33 +19,83 @@ Shader& Shader::Use()
 
 void Shader::Compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource)
 {
-    unsigned int sVertex, sFragment, gShader;
-    sVertex = glCreateShader(GL_VERTEX_SHADER);
+    this->Submit(vertexSource, fragmentSource, geometrySource);
+    this->Finish();
+}
+
+void Shader::Submit(const char* vertexSource, const char* fragmentSource, const char* geometrySource)
+{
+    this->stageCount = 0;
+    this->addStage(GL_VERTEX_SHADER, vertexSource, "VERTEX");
+    this->addStage(GL_FRAGMENT_SHADER, fragmentSource, "FRAGMENT");
+    if (geometrySource != nullptr)
+        this->addStage(GL_GEOMETRY_SHADER, geometrySource, "GEOMETRY");
+    this->ID = glCreateProgram();
+    for (int i = 0; i < this->stageCount; ++i)
+        glAttachShader(this->ID, this->stages[i]);
+    allowProgramBinary(this->ID);
+    glLinkProgram(this->ID);
+}
+
+bool Shader::Ready() const
+{
+    if (!GLEW_KHR_parallel_shader_compile || this->stageCount == 0)
+        return true;
+    GLint done = GL_FALSE;
+    glGetProgramiv(this->ID, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+void Shader::Finish()
+{
+    if (this->stageCount == 0)
+        return;
+    for (int i = 0; i < this->stageCount; ++i)
+        checkCompileErrors(this->stages[i], this->stageTypes[i]);
+    checkCompileErrors(this->ID, "PROGRAM");
+    for (int i = 0; i < this->stageCount; ++i)
+        glDeleteShader(this->stages[i]);
+    this->stageCount = 0;
+}
+
+void Shader::addStage(GLenum type, const char* source, const char* typeName)
+{
+    const unsigned int stage = glCreateShader(type);
+    glShaderSource(stage, 1, &source, NULL);
+    glCompileShader(stage);
+    this->stages[this->stageCount] = stage;
+    this->stageTypes[this->stageCount] = typeName;
+    this->stageCount++;
+}
+
+void Shader::CompileFeedback(const char* vertexSource, const char* const* varyings, int varyingCount)
+{
+    unsigned int sVertex = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(sVertex, 1, &vertexSource, NULL);
     glCompileShader(sVertex);
     checkCompileErrors(sVertex, "VERTEX");
-    sFragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(sFragment, 1, &fragmentSource, NULL);
-    glCompileShader(sFragment);
-    checkCompileErrors(sFragment, "FRAGMENT");
-    if (geometrySource != nullptr)
-    {
-        gShader = glCreateShader(GL_GEOMETRY_SHADER);
-        glShaderSource(gShader, 1, &geometrySource, NULL);
-        glCompileShader(gShader);
-        checkCompileErrors(gShader, "GEOMETRY");
-    }
     this->ID = glCreateProgram();
     glAttachShader(this->ID, sVertex);
-    glAttachShader(this->ID, sFragment);
-    if (geometrySource != nullptr)
-        glAttachShader(this->ID, gShader);
+    // the captured outputs have to be named before linking
+    glTransformFeedbackVaryings(this->ID, varyingCount, varyings, GL_INTERLEAVED_ATTRIBS);
+    allowProgramBinary(this->ID);
     glLinkProgram(this->ID);
     checkCompileErrors(this->ID, "PROGRAM");
     glDeleteShader(sVertex);
-    glDeleteShader(sFragment);
-    if (geometrySource != nullptr)
-        glDeleteShader(gShader);
+}
+
+void Shader::CompileCompute(const char* computeSource)
+{
+    unsigned int sCompute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(sCompute, 1, &computeSource, NULL);
+    glCompileShader(sCompute);
+    checkCompileErrors(sCompute, "COMPUTE");
+    this->ID = glCreateProgram();
+    glAttachShader(this->ID, sCompute);
+    allowProgramBinary(this->ID);
+    glLinkProgram(this->ID);
+    checkCompileErrors(this->ID, "PROGRAM");
+    glDeleteShader(sCompute);
 }
 
 void Shader::SetFloat(const char* name, float value, bool useShader)
@@ -14,6 +14,16 @@ public:
     Shader() { }
     Shader& Use();
     void    Compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource = nullptr); // note: geometry source code is optional 
+    // Compile split in two: Submit starts compiling and linking without asking for the result,
+    // so drivers with GL_KHR_parallel_shader_compile work on several programs at once.
+    // Finish reports errors and must come before the program is used.
+    void    Submit(const char* vertexSource, const char* fragmentSource, const char* geometrySource = nullptr);
+    // whether Finish would not block; always true without GL_KHR_parallel_shader_compile
+    bool    Ready() const;
+    void    Finish();
+    // vertex-only program whose outputs are captured, interleaved, with transform feedback
+    void    CompileFeedback(const char* vertexSource, const char* const* varyings, int varyingCount);
+    void    CompileCompute(const char* computeSource);
     void    SetFloat(const char* name, float value, bool useShader = false);
     void    SetInteger(const char* name, int value, bool useShader = false);
     void    SetVector2f(const char* name, float x, float y, bool useShader = false);
@@ -24,6 +34,10 @@ public:
     void    SetVector4f(const char* name, const glm::vec4& value, bool useShader = false);
     void    SetMatrix4(const char* name, const glm::mat4& matrix, bool useShader = false);
 private:
+    unsigned int stages[3] = {};        // compiled by Submit, deleted by Finish
+    const char*  stageTypes[3] = {};
+    int          stageCount = 0;
+    void    addStage(GLenum type, const char* source, const char* typeName);
     void    checkCompileErrors(unsigned int object, std::string type);
 };
 
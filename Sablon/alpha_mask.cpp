@@ -0,0 +1,65 @@
+#include "alpha_mask.h"
+
+AlphaMask::AlphaMask()
+    : Width(0), Height(0), OpaqueTop(1.0f), OpaqueBottom(0.0f), rowWords(0)
+{
+}
+
+void AlphaMask::Generate(const unsigned char* rgba, unsigned int width, unsigned int height, unsigned int maxSize, unsigned char threshold)
+{
+    const unsigned int longest = width > height ? width : height;
+    const unsigned int step = longest > maxSize ? (longest + maxSize - 1) / maxSize : 1;
+    this->Width = (width + step - 1) / step;
+    this->Height = (height + step - 1) / step;
+    this->rowWords = (this->Width + 63) / 64;
+    this->bits.assign(static_cast<size_t>(this->rowWords) * this->Height, 0);
+    unsigned int runStart = 0, bestStart = 0, bestLength = 0;
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        const unsigned char* row = rgba + static_cast<size_t>(y) * width * 4;
+        uint64_t* cells = &this->bits[static_cast<size_t>(y / step) * this->rowWords];
+        bool solid = true;
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            const unsigned char alpha = row[x * 4 + 3];
+            solid = solid && alpha == 255;
+            if (alpha >= threshold)
+            {
+                const unsigned int cell = x / step;
+                cells[cell / 64] |= uint64_t(1) << (cell % 64);
+            }
+        }
+        if (!solid)
+            runStart = y + 1;
+        else if (y + 1 - runStart > bestLength)
+        {
+            bestStart = runStart;
+            bestLength = y + 1 - runStart;
+        }
+    }
+    // one row in from each edge, linear filtering blends in the neighbouring rows
+    if (bestLength > 2)
+    {
+        this->OpaqueTop = static_cast<float>(bestStart + 1) / height;
+        this->OpaqueBottom = static_cast<float>(bestStart + bestLength - 1) / height;
+    }
+    else
+    {
+        this->OpaqueTop = 1.0f;
+        this->OpaqueBottom = 0.0f;
+    }
+}
+
+bool AlphaMask::Test(float u, float v) const
+{
+    if (u < 0.0f || u >= 1.0f || v < 0.0f || v >= 1.0f || this->bits.empty())
+        return false;
+    const unsigned int x = static_cast<unsigned int>(u * this->Width);
+    const unsigned int y = static_cast<unsigned int>(v * this->Height);
+    return (this->bits[static_cast<size_t>(y) * this->rowWords + x / 64] >> (x % 64)) & 1;
+}
+
+size_t AlphaMask::Bytes() const
+{
+    return this->bits.size() * sizeof(uint64_t);
+}
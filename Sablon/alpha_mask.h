@@ -0,0 +1,28 @@
+#pragma once
+#ifndef ALPHA_MASK_H
+#define ALPHA_MASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 1 bit per cell coverage of a texture's alpha channel, for pixel-accurate picking.
+// Large images are downsampled so the longer side fits maxSize cells; a cell is set
+// when any pixel it covers is at least the threshold, which errs on the side of a hit.
+class AlphaMask
+{
+public:
+    unsigned int Width, Height;     // in cells
+    // tallest band of fully opaque rows, as fractions of the height; empty when top >= bottom
+    float        OpaqueTop, OpaqueBottom;
+    AlphaMask();
+    void   Generate(const unsigned char* rgba, unsigned int width, unsigned int height, unsigned int maxSize = 256, unsigned char threshold = 128);
+    // u, v are texture coordinates, v = 0 being the first row of the image
+    bool   Test(float u, float v) const;
+    size_t Bytes() const;
+private:
+    std::vector<uint64_t> bits;
+    unsigned int          rowWords;
+};
+
+#endif
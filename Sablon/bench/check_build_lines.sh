@@ -0,0 +1,30 @@
+#!/bin/sh
+# Builds every benchmark with the command line at the top of its source, so a line that misses
+# a source file the game now needs, or names one in the wrong case, fails here rather than for
+# the next person who copies it. Needs everything the lines link against (GLFW, GLEW, FreeType);
+# CXXFLAGS is appended to each line, e.g. CXXFLAGS=-I/path/to/glm.
+# Exits with the number of lines that did not build.
+cd "$(dirname "$0")" || exit 1
+out=$(mktemp -d) || exit 1
+trap 'rm -rf "$out"' EXIT
+failed=0
+for source in *.cpp; do
+    # a line starts at "//   g++" and goes on over the indented comment lines up to "-o NAME"
+    awk '
+        /^\/\/   g\+\+ / { line = substr($0, 6); building = 1; }
+        building && /^\/\/       / { line = line " " substr($0, 10); }
+        building && / -o / { print line; building = 0; }
+    ' "$source" > "$out/lines"
+    while IFS= read -r line; do
+        # the binaries go to the scratch directory, not next to the sources
+        command=$(printf '%s\n' "$line" | sed "s# -o \([^ ]*\)# -o $out/\1#")
+        if eval "$command $CXXFLAGS" > "$out/log" 2>&1; then
+            echo "ok      $source"
+        else
+            echo "FAILED  $source: $line"
+            cat "$out/log"
+            failed=$((failed + 1))
+        fi
+    done < "$out/lines"
+done
+exit $failed
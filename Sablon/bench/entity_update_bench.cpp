@@ -0,0 +1,123 @@
+// Times the SIMD entity update kernel (integrate, bounce off bounds, fade) against its scalar
+// path and checks every path against the scalar results. Needs no glm and no GL context:
+//   g++ -O2 -DNDEBUG -std=c++14 -I.. entity_update_bench.cpp ../entity_update.cpp ../cpu_features.cpp -o entity_update_bench
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../entity_update.h"
+#include "../cpu_features.h"
+
+namespace
+{
+    struct Entities {
+        std::vector<float> PositionX, PositionY, VelocityX, VelocityY, Alpha, AlphaRate, MinX, MaxX, MinY, MaxY;
+        EntityStreams View()
+        {
+            return { PositionX.data(), PositionY.data(), VelocityX.data(), VelocityY.data(), Alpha.data(),
+                     AlphaRate.data(), MinX.data(), MaxX.data(), MinY.data(), MaxY.data(), PositionX.size() };
+        }
+    };
+
+    // fast movers in small boxes so plenty of them bounce every step
+    Entities makeEntities(size_t count)
+    {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        Entities entities;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float minX = unit(generator) * 1800.0f, minY = unit(generator) * 1000.0f;
+            entities.MinX.push_back(minX);
+            entities.MaxX.push_back(minX + 20.0f + unit(generator) * 100.0f);
+            entities.MinY.push_back(minY);
+            entities.MaxY.push_back(minY + 20.0f + unit(generator) * 60.0f);
+            entities.PositionX.push_back(minX + unit(generator) * 20.0f);
+            entities.PositionY.push_back(minY + unit(generator) * 20.0f);
+            entities.VelocityX.push_back((unit(generator) - 0.5f) * 4000.0f);
+            entities.VelocityY.push_back((unit(generator) - 0.5f) * 4000.0f);
+            entities.Alpha.push_back(unit(generator));
+            entities.AlphaRate.push_back((unit(generator) - 0.5f) * 20.0f);
+        }
+        return entities;
+    }
+
+    template <typename Function>
+    double nanosecondsPerEntity(size_t count, int repetitions, Function function)
+    {
+        function();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; ++i)
+            function();
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / repetitions / count;
+    }
+
+    float maxError(const Entities& a, const Entities& b)
+    {
+        float error = 0.0f;
+        const std::vector<float> Entities::* streams[] = {
+            &Entities::PositionX, &Entities::PositionY, &Entities::VelocityX, &Entities::VelocityY, &Entities::Alpha
+        };
+        for (const auto stream : streams)
+        {
+            for (size_t i = 0; i < (a.*stream).size(); ++i)
+                error = std::fmax(error, std::fabs((a.*stream)[i] - (b.*stream)[i]));
+        }
+        return error;
+    }
+}
+
+int main()
+{
+    constexpr float dt = 1.0f / 60.0f;
+    constexpr int steps = 10;
+    // only the paths compiled into this build; asking for another one runs one of these
+    struct NamedPath { UpdatePath Path; const char* Name; };
+    const NamedPath paths[] = {
+        { UPDATE_SCALAR, "scalar" },
+#if defined(CPU_X86_SIMD)
+        { UPDATE_SSE, "sse" },
+        { UPDATE_AVX2, "avx2" },
+#elif defined(CPU_ARM_NEON)
+        { UPDATE_NEON, "neon" },
+#endif
+    };
+    const UpdatePath best = BestUpdatePath();
+
+    for (const size_t count : { size_t(10000), size_t(100000), size_t(1000000) })
+    {
+        const Entities initial = makeEntities(count);
+        const int repetitions = static_cast<int>(20000000 / count);
+
+        // the same steps from the same start on the scalar path, to compare the others against
+        Entities reference = initial;
+        for (int step = 0; step < steps; ++step)
+            UpdateEntities(reference.View(), dt, UPDATE_SCALAR);
+
+        std::printf("%zu entities\n", count);
+        double scalarTime = 0.0;
+        for (const NamedPath& path : paths)
+        {
+            if (path.Path > best)
+                continue;
+            Entities entities = initial;
+            for (int step = 0; step < steps; ++step)
+                UpdateEntities(entities.View(), dt, path.Path);
+            const float error = maxError(reference, entities);
+
+            entities = initial;
+            const EntityStreams view = entities.View();
+            const double time = nanosecondsPerEntity(count, repetitions, [&] {
+                UpdateEntities(view, dt, path.Path);
+            });
+            if (path.Path == UPDATE_SCALAR)
+                scalarTime = time;
+            std::printf("  %-8s %6.3f ns/entity  %5.1fx  max error %g\n",
+                path.Name, time, scalarTime / time, error);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,347 @@
+// Microbenchmarks for the renderer, resource loading, text, shaders and the game update,
+// with JSON output and a regression check against a stored baseline. Needs a GL 3.3 context
+// (a hidden GLFW window), GLEW and FreeType; run it from the directory holding the shaders,
+// res/ and fonts/:
+//   g++ -O2 -DNDEBUG -std=c++14 -I.. micro_bench.cpp ../game.cpp ../game_object.cpp ../sprite_renderer.cpp
+//       ../text_renderer.cpp ../Shader.cpp ../texture.cpp ../resource_manager.cpp ../stb_image.cpp
+//       ../alpha_mask.cpp ../memory_tracker.cpp ../render_queue.cpp ../frame_arena.cpp ../render_cull.cpp
+//       ../sprite_transform.cpp ../cpu_features.cpp ../job_system.cpp ../spatial_grid.cpp ../layer_cache.cpp
+//       ../sky_renderer.cpp ../star_field.cpp ../particle_system.cpp ../entity_update.cpp ../entity_batch.cpp
+//       ../random.cpp ../render_trace.cpp ../shader_cache.cpp ../frame_constants.cpp ../camera_2d.cpp ../chunk_streamer.cpp
+//       ../resolution_scaler.cpp -lglfw -lGLEW -lGL -lfreetype -lpthread -o micro_bench
+// Usage: micro_bench [--filter TEXT] [--json FILE] [--compare BASELINE.json] [--threshold PERCENT]
+// --compare exits with code 2 when a benchmark got slower than the baseline by more than the
+// threshold (default 10%); write the baseline with --json from a known good build.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../Game.h"
+#include "../frame_constants.h"
+#include "../job_system.h"
+#include "../memory_tracker.h"
+#include "../render_queue.h"
+#include "../resource_manager.h"
+#include "../sprite_renderer.h"
+#include "../sprite_transform.h"
+#include "../text_renderer.h"
+
+namespace
+{
+    constexpr unsigned int screenWidth = 1920;
+    constexpr unsigned int screenHeight = 1080;
+
+    struct Result {
+        std::string Name;
+        double      NanosecondsPerOp;
+        long long   Iterations;     // per sample
+    };
+
+    const char*         filter = nullptr;
+    std::vector<Result> results;
+
+    // median of several samples, each long enough to hide the clock resolution
+    void measure(const std::string& name, size_t opsPerCall, const std::function<void()>& call)
+    {
+        if (filter && name.find(filter) == std::string::npos)
+            return;
+        using Clock = std::chrono::steady_clock;
+        constexpr int samples = 5;
+        constexpr double sampleSeconds = 0.05;
+        call();
+        long long iterations = 1;
+        for (;;)
+        {
+            const auto start = Clock::now();
+            for (long long i = 0; i < iterations; ++i)
+                call();
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (seconds >= sampleSeconds || iterations >= (1LL << 30))
+                break;
+            iterations = seconds > 0.0 ? std::max(iterations * 2, static_cast<long long>(iterations * sampleSeconds / seconds)) : iterations * 16;
+        }
+        std::vector<double> perOp;
+        for (int sample = 0; sample < samples; ++sample)
+        {
+            const auto start = Clock::now();
+            for (long long i = 0; i < iterations; ++i)
+                call();
+            perOp.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (iterations * opsPerCall));
+        }
+        std::sort(perOp.begin(), perOp.end());
+        results.push_back({ name, perOp[samples / 2], iterations });
+        std::printf("%-36s %14.1f ns/op\n", name.c_str(), perOp[samples / 2]);
+    }
+
+    std::string readFile(const char* path)
+    {
+        std::ifstream file(path);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    std::vector<SpriteCommand> makeSprites(size_t count, const Texture2D& texture)
+    {
+        std::vector<SpriteCommand> sprites(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float t = static_cast<float>(i) / count;
+            sprites[i] = { texture.ID, glm::vec2(t * screenWidth, (1.0f - t) * screenHeight), glm::vec2(64.0f, 64.0f),
+                           i % 10 == 0 ? 30.0f : 0.0f, glm::vec3(1.0f), 1.0f, (i & 1) != 0, 0.0f, glm::vec3(1.0f, 0.0f, 0.0f) };
+        }
+        return sprites;
+    }
+
+    void spriteSuite()
+    {
+        constexpr size_t count = 10000;
+        ResourceManager::LoadTexture("res/sun.png", true, "bench sprite");
+        Texture2D& texture = ResourceManager::GetTexture("bench sprite");
+        const std::vector<SpriteCommand> sprites = makeSprites(count, texture);
+        SpriteRenderer renderer(ResourceManager::GetShader("sprite"), ResourceManager::GetShader("sprite highlight"));
+
+        // what DrawSprite costs a recording frame per sprite
+        CommandBuffer commands;
+        measure("sprite/draw_sprite_record", count, [&] {
+            commands.Clear();
+            renderer.Begin(commands);
+            for (const auto& sprite : sprites)
+                renderer.DrawSprite(texture, sprite.Position, sprite.Size, sprite.Rotation, sprite.Color, sprite.Alpha,
+                                    sprite.IsFlippedHorizontally, sprite.Threshold, sprite.HighlightColor);
+            renderer.End();
+        });
+
+        std::vector<float> positionX(count), positionY(count), width(count), height(count), rotation(count);
+        std::vector<unsigned char> flip(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            positionX[i] = sprites[i].Position.x;
+            positionY[i] = sprites[i].Position.y;
+            width[i] = sprites[i].Size.x;
+            height[i] = sprites[i].Size.y;
+            rotation[i] = sprites[i].Rotation;
+            flip[i] = sprites[i].IsFlippedHorizontally;
+        }
+        std::vector<glm::vec2> corners(4 * count);
+        const SpriteTransforms view = { positionX.data(), positionY.data(), width.data(), height.data(), rotation.data(), flip.data(), count };
+        measure("sprite/transform", count, [&] { TransformSprites(view, corners.data()); });
+
+        measure("sprite/draw_batch", count, [&] {
+            renderer.DrawBatch(sprites.data(), sprites.size());
+            glFinish();
+        });
+    }
+
+    void textSuite()
+    {
+        TextRenderer text;
+        text.Load("fonts/Antonio-Regular.ttf", 24);
+        const char* line = "Ognjen Gligoric SV79/2021 - To be continued in 3D game";
+        const size_t length = std::strlen(line);
+        measure("text/render_text", length, [&] {
+            text.RenderText(line, 10.0f, 10.0f, 1.0f);
+            glFinish();
+        });
+    }
+
+    void textureSuite()
+    {
+        struct Format {
+            const char* Name;
+            const char* File;
+            bool        Alpha;
+        };
+        const Format formats[] = {
+            { "resource/load_texture/png_rgba", "res/sun.png", true },
+            { "resource/load_texture/png_rgb", "res/texel_checker.png", false },
+            { "resource/load_texture/jpg", "res/door.jpg", true },
+        };
+        for (const auto& format : formats)
+        {
+            measure(format.Name, 1, [&] {
+                const Texture2D texture = ResourceManager::LoadTexture(format.File, format.Alpha, "bench texture");
+                glFinish();
+                glDeleteTextures(1, &texture.ID);
+                MemoryTracker::UntrackTexture(texture.ID);
+                ResourceManager::AlphaMasks.erase(texture.ID);
+            });
+        }
+    }
+
+    void shaderSuite()
+    {
+        const char* programs[][3] = {
+            { "shader/compile/sprite", "sprite.vert", "sprite.frag" },
+            { "shader/compile/text", "text.vert", "text.frag" },
+            { "shader/compile/sky", "sky.vert", "sky.frag" },
+        };
+        for (const auto& program : programs)
+        {
+            const std::string vertex = readFile(program[1]), fragment = readFile(program[2]);
+            measure(program[0], 1, [&] {
+                Shader shader;
+                shader.Compile(vertex.c_str(), fragment.c_str());
+                glDeleteProgram(shader.ID);
+            });
+        }
+    }
+
+    // the scene scaled up, recorded the way the threaded render path records it
+    void gameSuite()
+    {
+        for (const unsigned int scale : { 1u, 10u, 100u })
+        {
+            Game game(screenWidth, screenHeight);
+            game.Seed = 1;
+            game.StarCount *= scale;
+            game.PyramidCount *= scale;
+            game.GrassCount *= scale;
+            game.ParticleCount *= scale;
+            game.Init();
+            const std::string suffix = "/x" + std::to_string(scale);
+            measure("game/update" + suffix, 1, [&] { game.Update(1.0f / 60.0f); });
+            CommandBuffer commands;
+            measure("game/record" + suffix, 1, [&] {
+                commands.Clear();
+                game.Record(commands);
+            });
+        }
+    }
+
+    void writeJson(std::FILE* file)
+    {
+        std::fprintf(file, "{\n  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            std::fprintf(file, "    { \"name\": \"%s\", \"ns_per_op\": %.3f, \"iterations\": %lld }%s\n",
+                results[i].Name.c_str(), results[i].NanosecondsPerOp, results[i].Iterations, i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+    }
+
+    // reads back what writeJson wrote; returns false when the file cannot be read
+    bool readBaseline(const char* path, std::map<std::string, double>& baseline)
+    {
+        std::ifstream file(path);
+        if (!file)
+            return false;
+        const std::string json = readFile(path);
+        const std::regex entry("\"name\"\\s*:\\s*\"([^\"]+)\"\\s*,\\s*\"ns_per_op\"\\s*:\\s*([-+0-9.eE]+)");
+        for (auto match = std::sregex_iterator(json.begin(), json.end(), entry); match != std::sregex_iterator(); ++match)
+            baseline[(*match)[1].str()] = std::atof((*match)[2].str().c_str());
+        return true;
+    }
+
+    int compare(const char* path, double thresholdPercent)
+    {
+        std::map<std::string, double> baseline;
+        if (!readBaseline(path, baseline))
+        {
+            std::printf("cannot read baseline %s\n", path);
+            return 1;
+        }
+        int regressions = 0;
+        std::printf("\ncompared with %s, threshold %.1f%%\n", path, thresholdPercent);
+        for (const auto& result : results)
+        {
+            const auto found = baseline.find(result.Name);
+            if (found == baseline.end())
+            {
+                std::printf("%-36s %14s\n", result.Name.c_str(), "new");
+                continue;
+            }
+            const double change = (result.NanosecondsPerOp / found->second - 1.0) * 100.0;
+            const bool regressed = change > thresholdPercent;
+            regressions += regressed;
+            std::printf("%-36s %+13.1f%%%s\n", result.Name.c_str(), change, regressed ? "  REGRESSION" : "");
+        }
+        return regressions > 0 ? 2 : 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    double thresholdPercent = 10.0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+            baselinePath = argv[++i];
+        else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            thresholdPercent = std::atof(argv[++i]);
+    }
+
+    if (!glfwInit())
+        return 1;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(screenWidth, screenHeight, "micro_bench", NULL, NULL);
+    if (window == NULL)
+        return 1;
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (glewInit() != GLEW_OK)
+        return 1;
+    glViewport(0, 0, screenWidth, screenHeight);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    JobSystem::Init();
+
+    ResourceManager::LoadShader("sprite.vert", "sprite.frag", nullptr, "sprite");
+    ResourceManager::LoadShader("sprite.vert", "sprite.frag", nullptr, "sprite highlight", { "HIGHLIGHT" });
+    ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
+    ResourceManager::GetShader("sprite highlight").Use().SetInteger("image", 0);
+    {
+        FrameConstantsBuffer frame;
+        frame.Update({ glm::ortho(0.0f, static_cast<float>(screenWidth), static_cast<float>(screenHeight), 0.0f, -1.0f, 1.0f),
+                       glm::mat4(1.0f), glm::vec2(screenWidth, screenHeight), 0.0f, 0.0f });
+        spriteSuite();
+        textSuite();
+        textureSuite();
+        shaderSuite();
+        // every game binds frame constants of its own
+        gameSuite();
+    }
+
+    int exitCode = 0;
+    if (jsonPath)
+    {
+        std::FILE* file = std::fopen(jsonPath, "w");
+        if (file)
+        {
+            writeJson(file);
+            std::fclose(file);
+        }
+        else
+            std::printf("cannot write %s\n", jsonPath);
+    }
+    if (baselinePath)
+        exitCode = compare(baselinePath, thresholdPercent);
+
+    ResourceManager::Clear();
+    JobSystem::Shutdown();
+    glfwTerminate();
+    return exitCode;
+}
@@ -0,0 +1,366 @@
+// Replays a render trace recorded with `--trace FILE` against one backend in a loop, so
+// renderer changes can be timed on real scenes without running the game:
+//   mock      walks the commands and counts draw calls, the floor any backend pays
+//   software  transforms every sprite with the SIMD kernel and blends its bounds into a CPU framebuffer
+//   gl        SpriteRenderer::DrawBatch and TextRenderer, as Game::Execute draws them
+// mock and software need only glm:
+//   g++ -O2 -DNDEBUG -std=c++14 -I.. render_trace_bench.cpp ../render_trace.cpp ../sprite_transform.cpp ../cpu_features.cpp -o render_trace_bench
+// gl also needs GLFW, GLEW and FreeType, and must run from the directory holding the shaders and fonts:
+//   g++ -O2 -DNDEBUG -std=c++14 -DRENDER_TRACE_GL -I.. render_trace_bench.cpp ../render_trace.cpp ../sprite_transform.cpp ../cpu_features.cpp
+//       ../sprite_renderer.cpp ../text_renderer.cpp ../Shader.cpp ../texture.cpp ../resource_manager.cpp ../stb_image.cpp
+//       ../alpha_mask.cpp ../memory_tracker.cpp ../render_queue.cpp ../frame_arena.cpp ../shader_cache.cpp
+//       ../frame_constants.cpp -lglfw -lGLEW -lGL -lfreetype -o render_trace_bench
+// Usage: render_trace_bench TRACE [mock|software|gl] [repetitions]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../render_trace.h"
+#include "../sprite_transform.h"
+
+#if defined(RENDER_TRACE_GL)
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "../resource_manager.h"
+#include "../sprite_renderer.h"
+#include "../text_renderer.h"
+#include "../frame_constants.h"
+#endif
+
+namespace
+{
+    class Backend
+    {
+    public:
+        virtual ~Backend() { }
+        // the frame constants the game drew the frame through
+        virtual void BeginFrame(const FrameConstants& frame) { }
+        // a run of consecutive sprite commands, the unit Game::Execute batches
+        virtual void DrawSprites(const SpriteCommand* sprites, size_t count) = 0;
+        virtual void DrawText(const TextCommand& text) = 0;
+        virtual void EndFrame() { }
+        virtual void Report(size_t frames) const { }
+    };
+
+    class MockBackend : public Backend
+    {
+    public:
+        void DrawSprites(const SpriteCommand* sprites, size_t count) override
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (i == 0 || sprites[i].TextureID != sprites[i - 1].TextureID)
+                    drawCalls++;
+            }
+            spriteCount += count;
+        }
+        void DrawText(const TextCommand& text) override
+        {
+            characters += text.Length;
+        }
+        void Report(size_t frames) const override
+        {
+            std::printf("  per frame: %.1f sprites, %.1f sprite draw calls, %.1f characters\n",
+                double(spriteCount) / frames, double(drawCalls) / frames, double(characters) / frames);
+        }
+    private:
+        size_t spriteCount = 0, drawCalls = 0, characters = 0;
+    };
+
+    class SoftwareBackend : public Backend
+    {
+    public:
+        SoftwareBackend()
+            : width(0), height(0)
+        {
+        }
+        void BeginFrame(const FrameConstants& frame) override
+        {
+            width = static_cast<unsigned int>(frame.ViewportSize.x);
+            height = static_cast<unsigned int>(frame.ViewportSize.y);
+            pixels.assign(size_t(width) * height * 4, 0);
+            // world to clip space as the shaders do it, then clip space to pixels with y down
+            toPixels = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.5f * width, 0.5f * height, 0.0f)),
+                                  glm::vec3(0.5f * width, -0.5f * height, 1.0f))
+                     * frame.Projection * frame.View;
+        }
+        void DrawSprites(const SpriteCommand* sprites, size_t count) override
+        {
+            positionX.resize(count); positionY.resize(count); spriteWidth.resize(count);
+            spriteHeight.resize(count); rotation.resize(count); flip.resize(count); corners.resize(4 * count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                positionX[i] = sprites[i].Position.x;
+                positionY[i] = sprites[i].Position.y;
+                spriteWidth[i] = sprites[i].Size.x;
+                spriteHeight[i] = sprites[i].Size.y;
+                rotation[i] = sprites[i].Rotation;
+                flip[i] = sprites[i].IsFlippedHorizontally;
+            }
+            const SpriteTransforms view = { positionX.data(), positionY.data(), spriteWidth.data(), spriteHeight.data(),
+                                            rotation.data(), flip.data(), count };
+            TransformSprites(view, corners.data());
+            for (size_t i = 0; i < count; ++i)
+            {
+                const glm::vec2* quad = &corners[4 * i];
+                const glm::vec2 a = toPixel(quad[0]), b = toPixel(quad[1]), c = toPixel(quad[2]), d = toPixel(quad[3]);
+                const glm::vec2 min = glm::min(glm::min(a, b), glm::min(c, d));
+                const glm::vec2 max = glm::max(glm::max(a, b), glm::max(c, d));
+                fill(min, max, sprites[i].Color, sprites[i].Alpha);
+            }
+        }
+        // one box per character, about the size of a glyph of the 24 px game font
+        void DrawText(const TextCommand& text) override
+        {
+            const float advance = 12.0f * text.Scale, lineHeight = 24.0f * text.Scale;
+            for (size_t i = 0; i < text.Length; ++i)
+            {
+                const glm::vec2 a = toPixel(glm::vec2(text.X + i * advance, text.Y));
+                const glm::vec2 b = toPixel(glm::vec2(text.X + i * advance + advance * 0.8f, text.Y + lineHeight));
+                fill(glm::min(a, b), glm::max(a, b), text.Color, text.Alpha);
+            }
+        }
+        void Report(size_t frames) const override
+        {
+            unsigned long long sum = 0;
+            for (const unsigned char value : pixels)
+                sum += value;
+            std::printf("  last frame checksum %llu\n", sum);
+        }
+    private:
+        unsigned int               width, height;
+        std::vector<unsigned char> pixels;
+        std::vector<float>         positionX, positionY, spriteWidth, spriteHeight, rotation;
+        std::vector<unsigned char> flip;
+        std::vector<glm::vec2>     corners;
+        glm::mat4                  toPixels;
+
+        glm::vec2 toPixel(glm::vec2 world) const
+        {
+            return glm::vec2(toPixels * glm::vec4(world, 0.0f, 1.0f));
+        }
+
+        void fill(glm::vec2 min, glm::vec2 max, glm::vec3 color, float alpha)
+        {
+            const int x0 = std::max(0, int(std::floor(min.x))), x1 = std::min(int(width), int(std::ceil(max.x)));
+            const int y0 = std::max(0, int(std::floor(min.y))), y1 = std::min(int(height), int(std::ceil(max.y)));
+            if (alpha <= 0.0f || x0 >= x1 || y0 >= y1)
+                return;
+            const int a = int(alpha * 256.0f), keep = 256 - a;
+            const int r = int(color.x * 255.0f) * a, g = int(color.y * 255.0f) * a, b = int(color.z * 255.0f) * a;
+            for (int y = y0; y < y1; ++y)
+            {
+                unsigned char* pixel = &pixels[(size_t(y) * width + x0) * 4];
+                for (int x = x0; x < x1; ++x, pixel += 4)
+                {
+                    pixel[0] = static_cast<unsigned char>((pixel[0] * keep + r) >> 8);
+                    pixel[1] = static_cast<unsigned char>((pixel[1] * keep + g) >> 8);
+                    pixel[2] = static_cast<unsigned char>((pixel[2] * keep + b) >> 8);
+                    pixel[3] = static_cast<unsigned char>((pixel[3] * keep + 255 * a) >> 8);
+                }
+            }
+        }
+    };
+
+#if defined(RENDER_TRACE_GL)
+    class GLBackend : public Backend
+    {
+    public:
+        // the trace keeps texture sizes, not pixels, so every texture is a white stand-in of the
+        // recorded size and the sprite commands are pointed at the stand-ins
+        GLBackend(RenderTrace& trace)
+        {
+            glfwInit();
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            window = glfwCreateWindow(trace.Width, trace.Height, "render trace", NULL, NULL);
+            glfwMakeContextCurrent(window);
+            glewInit();
+            glViewport(0, 0, trace.Width, trace.Height);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+            ResourceManager::LoadShader("sprite.vert", "sprite.frag", nullptr, "sprite");
+            ResourceManager::LoadShader("sprite.vert", "sprite.frag", nullptr, "sprite highlight", { "HIGHLIGHT" });
+            ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
+            ResourceManager::GetShader("sprite highlight").Use().SetInteger("image", 0);
+            frame.reset(new FrameConstantsBuffer());
+            sprites.reset(new SpriteRenderer(ResourceManager::GetShader("sprite"), ResourceManager::GetShader("sprite highlight")));
+            text.reset(new TextRenderer());
+            text->Load("fonts/Antonio-Regular.ttf", 24);
+
+            std::map<unsigned int, unsigned int> standIns;
+            for (const auto& recorded : trace.Textures)
+            {
+                std::vector<unsigned char> white(size_t(recorded.Width) * recorded.Height * 4, 255);
+                Texture2D texture;
+                texture.Internal_Format = GL_RGBA;
+                texture.Image_Format = GL_RGBA;
+                texture.Generate(recorded.Width, recorded.Height, white.data());
+                standIns[recorded.ID] = texture.ID;
+            }
+            for (auto& frame : trace.Frames)
+            {
+                for (auto& sprite : frame.Sprites)
+                    sprite.TextureID = standIns[sprite.TextureID];
+            }
+        }
+        ~GLBackend() override
+        {
+            sprites.reset();
+            text.reset();
+            frame.reset();
+            ResourceManager::Clear();
+            glfwTerminate();
+        }
+        void BeginFrame(const FrameConstants& constants) override
+        {
+            frame->Update(constants);
+            glViewport(0, 0, static_cast<GLsizei>(constants.ViewportSize.x), static_cast<GLsizei>(constants.ViewportSize.y));
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        void DrawSprites(const SpriteCommand* commands, size_t count) override
+        {
+            sprites->DrawBatch(commands, count);
+        }
+        void DrawText(const TextCommand& command) override
+        {
+            text->Execute(command);
+        }
+        // wait for the GPU so the time covers the drawing, not just the submission
+        void EndFrame() override
+        {
+            glFinish();
+        }
+    private:
+        GLFWwindow*                     window;
+        std::unique_ptr<SpriteRenderer> sprites;
+        std::unique_ptr<TextRenderer>   text;
+        std::unique_ptr<FrameConstantsBuffer> frame;
+    };
+#endif
+
+    // The trace is written before culling. Like the game, drop the sprites outside the recorded
+    // view before drawing, so every backend gets the sprites the game could have drawn, not every
+    // resident chunk. Returns how many were dropped.
+    size_t dropOffscreen(RenderTrace& trace)
+    {
+        size_t dropped = 0;
+        for (auto& frame : trace.Frames)
+        {
+            const glm::mat4 toWorld = glm::inverse(frame.Frame.Projection * frame.Frame.View);
+            const glm::vec2 a(toWorld * glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f));
+            const glm::vec2 b(toWorld * glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
+            const glm::vec2 viewMin = glm::min(a, b), viewMax = glm::max(a, b);
+            // consecutive sprite commands have to index consecutive sprites, so the kept ones are packed
+            std::vector<SpriteCommand> sprites;
+            size_t kept = 0;
+            for (size_t i = 0; i < frame.Commands.size(); ++i)
+            {
+                RenderCommand command = frame.Commands[i];
+                if (command.Type == RENDER_SPRITE)
+                {
+                    const SpriteCommand& sprite = frame.Sprites[command.Index];
+                    // half the diagonal reaches every corner at any rotation
+                    const glm::vec2 center = sprite.Position + 0.5f * sprite.Size;
+                    const float reach = 0.5f * std::sqrt(sprite.Size.x * sprite.Size.x + sprite.Size.y * sprite.Size.y);
+                    if (center.x + reach < viewMin.x || center.x - reach > viewMax.x
+                        || center.y + reach < viewMin.y || center.y - reach > viewMax.y)
+                    {
+                        dropped++;
+                        continue;
+                    }
+                    command.Index = static_cast<unsigned int>(sprites.size());
+                    sprites.push_back(sprite);
+                }
+                frame.Commands[kept++] = command;
+            }
+            frame.Commands.resize(kept);
+            frame.Sprites = std::move(sprites);
+        }
+        return dropped;
+    }
+
+    void replayFrame(const TraceFrame& frame, Backend& backend)
+    {
+        backend.BeginFrame(frame.Frame);
+        size_t i = 0;
+        while (i < frame.Commands.size())
+        {
+            const RenderCommand& command = frame.Commands[i];
+            if (command.Type == RENDER_TEXT)
+            {
+                backend.DrawText(frame.Texts[command.Index]);
+                ++i;
+                continue;
+            }
+            size_t end = i + 1;
+            while (end < frame.Commands.size() && frame.Commands[end].Type == RENDER_SPRITE)
+                ++end;
+            backend.DrawSprites(&frame.Sprites[command.Index], end - i);
+            i = end;
+        }
+        backend.EndFrame();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::printf("usage: %s TRACE [mock|software|gl] [repetitions]\n", argv[0]);
+        return 1;
+    }
+    const char* backendName = argc > 2 ? argv[2] : "mock";
+    const int repetitions = argc > 3 ? std::max(1, std::atoi(argv[3])) : 10;
+
+    RenderTrace trace;
+    if (!trace.Load(argv[1]) || trace.Frames.empty())
+        return 1;
+    const size_t offscreen = dropOffscreen(trace);
+
+    std::unique_ptr<Backend> backend;
+    if (std::strcmp(backendName, "mock") == 0)
+        backend.reset(new MockBackend());
+    else if (std::strcmp(backendName, "software") == 0)
+        backend.reset(new SoftwareBackend());
+#if defined(RENDER_TRACE_GL)
+    else if (std::strcmp(backendName, "gl") == 0)
+        backend.reset(new GLBackend(trace));
+#endif
+    else
+    {
+        std::printf("unknown backend %s\n", backendName);
+        return 1;
+    }
+
+    // one untimed pass warms caches and grows the backend's buffers
+    for (const auto& frame : trace.Frames)
+        replayFrame(frame, *backend);
+    const auto start = std::chrono::steady_clock::now();
+    for (int repetition = 0; repetition < repetitions; ++repetition)
+    {
+        for (const auto& frame : trace.Frames)
+            replayFrame(frame, *backend);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const size_t frames = trace.Frames.size() * repetitions;
+    const double microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+
+    std::printf("%s: %zu frames of %ux%u, %d repetitions\n", backendName, trace.Frames.size(), trace.Width, trace.Height, repetitions);
+    std::printf("  %.1f us/frame, %zu off-screen sprites dropped from the trace\n", microseconds / frames, offscreen);
+    backend->Report(trace.Frames.size() * (repetitions + 1));
+    return 0;
+}
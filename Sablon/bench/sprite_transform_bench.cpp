@@ -0,0 +1,115 @@
+// Compares the SIMD sprite transform kernel against the per-sprite glm::mat4 chain
+// SpriteRenderer used before batching. Needs only glm, no GL context:
+//   g++ -O2 -DNDEBUG -std=c++14 -I.. sprite_transform_bench.cpp ../sprite_transform.cpp ../cpu_features.cpp -o sprite_transform_bench
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../sprite_transform.h"
+
+namespace
+{
+    struct Sprites {
+        std::vector<float>         PositionX, PositionY, Width, Height, Rotation;
+        std::vector<unsigned char> Flip;
+        SpriteTransforms View() const
+        {
+            return { PositionX.data(), PositionY.data(), Width.data(), Height.data(), Rotation.data(), Flip.data(), PositionX.size() };
+        }
+    };
+
+    Sprites makeSprites(size_t count, float rotatedFraction)
+    {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        Sprites sprites;
+        for (size_t i = 0; i < count; ++i)
+        {
+            sprites.PositionX.push_back(unit(generator) * 1920.0f);
+            sprites.PositionY.push_back(unit(generator) * 1080.0f);
+            sprites.Width.push_back(10.0f + unit(generator) * 200.0f);
+            sprites.Height.push_back(10.0f + unit(generator) * 200.0f);
+            sprites.Rotation.push_back(unit(generator) < rotatedFraction ? unit(generator) * 360.0f : 0.0f);
+            sprites.Flip.push_back(unit(generator) < 0.5f ? 1 : 0);
+        }
+        return sprites;
+    }
+
+    // the model matrix SpriteRenderer::DrawSprite used to build, applied to the four quad corners
+    void transformGlm(const Sprites& sprites, glm::vec2* corners)
+    {
+        static const glm::vec2 unitCorners[4] = {
+            glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f)
+        };
+        for (size_t i = 0; i < sprites.PositionX.size(); ++i)
+        {
+            const glm::vec2 position(sprites.PositionX[i], sprites.PositionY[i]);
+            const glm::vec2 size(sprites.Width[i], sprites.Height[i]);
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(position, 0.0f));
+            model = glm::translate(model, glm::vec3(0.5f * size.x, 0.5f * size.y, 0.0f));
+            model = glm::rotate(model, glm::radians(sprites.Rotation[i]), glm::vec3(0.0f, 0.0f, 1.0f));
+            if (sprites.Flip[i])
+                model = glm::scale(model, glm::vec3(-1.0f, 1.0f, 1.0f));
+            model = glm::translate(model, glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f));
+            model = glm::scale(model, glm::vec3(size, 1.0f));
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                const glm::vec4 world = model * glm::vec4(unitCorners[corner], 0.0f, 1.0f);
+                corners[4 * i + corner] = glm::vec2(world.x, world.y);
+            }
+        }
+    }
+
+    template <typename Function>
+    double nanosecondsPerSprite(size_t count, int repetitions, Function function)
+    {
+        function();
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; ++i)
+            function();
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / repetitions / count;
+    }
+
+    float maxError(const std::vector<glm::vec2>& a, const std::vector<glm::vec2>& b)
+    {
+        float error = 0.0f;
+        for (size_t i = 0; i < a.size(); ++i)
+            error = std::fmax(error, std::fmax(std::fabs(a[i].x - b[i].x), std::fabs(a[i].y - b[i].y)));
+        return error;
+    }
+}
+
+int main()
+{
+    constexpr size_t count = 100000;
+    constexpr int repetitions = 50;
+    const char* pathNames[] = { "scalar", "sse", "avx2" };
+    const TransformPath best = BestTransformPath();
+
+    for (const float rotatedFraction : { 0.0f, 0.1f, 1.0f })
+    {
+        const Sprites sprites = makeSprites(count, rotatedFraction);
+        const SpriteTransforms view = sprites.View();
+        std::vector<glm::vec2> reference(4 * count), corners(4 * count);
+
+        const double glmTime = nanosecondsPerSprite(count, repetitions, [&] { transformGlm(sprites, reference.data()); });
+        std::printf("%zu sprites, %3.0f%% rotated\n", count, rotatedFraction * 100.0f);
+        std::printf("  %-8s %7.2f ns/sprite\n", "glm", glmTime);
+        for (int path = TRANSFORM_SCALAR; path <= best; ++path)
+        {
+            const double time = nanosecondsPerSprite(count, repetitions, [&] {
+                TransformSprites(view, corners.data(), static_cast<TransformPath>(path));
+            });
+            std::printf("  %-8s %7.2f ns/sprite  %5.1fx  max error %.4f px\n",
+                pathNames[path], time, glmTime / time, maxError(reference, corners));
+        }
+    }
+    return 0;
+}
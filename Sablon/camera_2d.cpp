@@ -0,0 +1,85 @@
+#include "camera_2d.h"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+constexpr float minZoom = 0.5f;
+constexpr float maxZoom = 8.0f;
+
+Camera2D::Camera2D()
+    : Camera2D(glm::vec2(1.0f, 1.0f), glm::vec2(1.0f, 1.0f)) { }
+
+Camera2D::Camera2D(glm::vec2 worldSize, glm::vec2 viewportSize)
+    : Position(0.5f * worldSize), Zoom(1.0f), world(worldSize), viewport(viewportSize),
+      boundsMin(0.0f, 0.0f), boundsMax(worldSize) { }
+
+void Camera2D::SetViewport(glm::vec2 size)
+{
+    if (size.x > 0.0f && size.y > 0.0f)
+        this->viewport = size;
+}
+
+void Camera2D::SetBounds(glm::vec2 min, glm::vec2 max)
+{
+    this->boundsMin = min;
+    this->boundsMax = max;
+    this->clampPosition();
+}
+
+void Camera2D::Pan(glm::vec2 delta)
+{
+    this->Position += delta;
+    this->clampPosition();
+}
+
+void Camera2D::ZoomBy(float factor, glm::vec2 screenPoint)
+{
+    const glm::vec2 before = this->ScreenToWorld(screenPoint);
+    this->Zoom = std::min(std::max(this->Zoom * factor, minZoom), maxZoom);
+    this->Position += before - this->ScreenToWorld(screenPoint);
+    this->clampPosition();
+}
+
+void Camera2D::Reset()
+{
+    this->Position = 0.5f * this->world;
+    this->Zoom = 1.0f;
+}
+
+glm::mat4 Camera2D::Projection() const
+{
+    const glm::vec2 half = 0.5f * this->viewport / this->pixelsPerUnit();
+    return glm::ortho(-half.x, half.x, half.y, -half.y, -1.0f, 1.0f);
+}
+
+glm::mat4 Camera2D::View() const
+{
+    const glm::mat4 zoom = glm::scale(glm::mat4(1.0f), glm::vec3(this->Zoom, this->Zoom, 1.0f));
+    return glm::translate(zoom, glm::vec3(-this->Position, 0.0f));
+}
+
+glm::vec2 Camera2D::ScreenToWorld(glm::vec2 point) const
+{
+    return this->Position + (point - 0.5f * this->viewport) / (this->pixelsPerUnit() * this->Zoom);
+}
+
+glm::vec2 Camera2D::VisibleMin() const
+{
+    return this->ScreenToWorld(glm::vec2(0.0f, 0.0f));
+}
+
+glm::vec2 Camera2D::VisibleMax() const
+{
+    return this->ScreenToWorld(this->viewport);
+}
+
+float Camera2D::pixelsPerUnit() const
+{
+    return std::min(this->viewport.x / this->world.x, this->viewport.y / this->world.y);
+}
+
+void Camera2D::clampPosition()
+{
+    this->Position = glm::clamp(this->Position, this->boundsMin, this->boundsMax);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef CAMERA_2D_H
+#define CAMERA_2D_H
+
+#include <glm/glm.hpp>
+
+// Pans and zooms over a world of worldSize units. At zoom 1 the whole world fits the viewport,
+// keeping its aspect ratio; Position is the world point at the center of the viewport.
+// Drawing, culling and picking all go through the same camera, so they agree on what is seen.
+class Camera2D
+{
+public:
+    glm::vec2 Position;
+    float     Zoom;
+    Camera2D();
+    Camera2D(glm::vec2 worldSize, glm::vec2 viewportSize);
+    // viewport size in pixels; ignored while minimized
+    void      SetViewport(glm::vec2 size);
+    glm::vec2 Viewport() const { return this->viewport; }
+    // where the center may go, the world by default
+    void      SetBounds(glm::vec2 min, glm::vec2 max);
+    // moves by delta world units, keeping the center inside the bounds
+    void      Pan(glm::vec2 delta);
+    // multiplies the zoom by factor, keeping the world point under screenPoint where it is
+    void      ZoomBy(float factor, glm::vec2 screenPoint);
+    // back to the whole world at zoom 1
+    void      Reset();
+    // the viewport in world units at zoom 1, centered on the origin
+    glm::mat4 Projection() const;
+    // pan and zoom
+    glm::mat4 View() const;
+    glm::vec2 ScreenToWorld(glm::vec2 point) const;
+    // world bounds of what the viewport shows
+    glm::vec2 VisibleMin() const;
+    glm::vec2 VisibleMax() const;
+private:
+    glm::vec2 world;
+    glm::vec2 viewport;
+    glm::vec2 boundsMin, boundsMax;
+    float     pixelsPerUnit() const;
+    void      clampPosition();
+};
+
+#endif
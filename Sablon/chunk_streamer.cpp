@@ -0,0 +1,214 @@
+#include "chunk_streamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Game.h"
+#include "memory_tracker.h"
+#include "random.h"
+#include "spatial_grid.h"
+
+// chunk streams start far above the scene's own streams, one per chunk index
+constexpr unsigned long long chunkStreamBase = 1ull << 32;
+// requests a synchronous streamer keeps in flight, whatever the worker count
+constexpr size_t synchronousPending = 4;
+
+ChunkStreamer::ChunkStreamer(const ChunkSettings& settings, SpatialGrid& scene, int radius, size_t budget, bool synchronous)
+    : settings(settings), scene(scene), radius(radius), budget(budget), synchronous(synchronous), bytes(0), lastChunkBytes(0) { }
+
+ChunkStreamer::~ChunkStreamer()
+{
+    for (const auto& request : this->pending)
+        JobSystem::Wait(request->Done);
+    while (!this->resident.empty())
+        this->evict(this->resident.size() - 1);
+}
+
+bool ChunkStreamer::Update(float minX, float maxX)
+{
+    const float width = this->settings.Size.x;
+    const int firstVisible = static_cast<int>(std::floor(minX / width));
+    const int lastVisible = static_cast<int>(std::floor(maxX / width));
+    const int first = firstVisible - this->radius, last = lastVisible + this->radius;
+    bool changed = false;
+
+    // take in finished chunks, dropping the ones the view has left meanwhile; a synchronous
+    // streamer takes in every chunk the frame after it was requested
+    for (size_t i = 0; i < this->pending.size();)
+    {
+        Request& request = *this->pending[i];
+        if (this->synchronous)
+            JobSystem::Wait(request.Done);
+        else if (request.Done.Pending.load(std::memory_order_acquire) > 0)
+        {
+            ++i;
+            continue;
+        }
+        if (request.Chunk.Index >= first && request.Chunk.Index <= last)
+        {
+            this->insert(std::unique_ptr<DesertChunk>(new DesertChunk(std::move(request.Chunk))));
+            changed = true;
+        }
+        this->pending.erase(this->pending.begin() + i);
+    }
+
+    // evict what left the radius, with a chunk of slack so a camera on a border does not thrash
+    for (size_t i = this->resident.size(); i-- > 0;)
+    {
+        const int index = this->resident[i]->Index;
+        if (index < first - 1 || index > last + 1)
+        {
+            this->evict(i);
+            changed = true;
+        }
+    }
+    // then the furthest while over budget, but never a chunk in view
+    const float center = 0.5f * (minX + maxX) / width;
+    while (this->bytes > this->budget)
+    {
+        size_t furthest = this->resident.size();
+        float furthestDistance = -1.0f;
+        for (size_t i = 0; i < this->resident.size(); ++i)
+        {
+            const int index = this->resident[i]->Index;
+            const float distance = std::fabs(static_cast<float>(index) + 0.5f - center);
+            if ((index < firstVisible || index > lastVisible) && distance > furthestDistance)
+            {
+                furthest = i;
+                furthestDistance = distance;
+            }
+        }
+        if (furthest == this->resident.size())
+            break;
+        this->evict(furthest);
+        changed = true;
+    }
+
+    // request missing chunks nearest first, a few at a time so the workers keep up with
+    // the game; the ones only the radius wants wait until the budget has room for them
+    const size_t maxPending = this->synchronous ? synchronousPending : JobSystem::ThreadCount();
+    const int middle = static_cast<int>(std::floor(center));
+    for (int step = 0; step <= last - first && this->pending.size() < maxPending; ++step)
+    {
+        for (const int index : { middle - step, middle + step })
+        {
+            if (index < first || index > last || index == 0 || this->pending.size() >= maxPending)
+                continue;
+            const bool visible = index >= firstVisible && index <= lastVisible;
+            if (!visible && this->bytes + this->lastChunkBytes > this->budget)
+                continue;
+            if (this->isResident(index) || this->isPending(index))
+                continue;
+            MemoryScope scope(MEMORY_SCENE);
+            this->pending.push_back(std::unique_ptr<Request>(new Request()));
+            Request& request = *this->pending.back();
+            request.Settings = &this->settings;
+            request.Chunk.Index = index;
+            JobSystem::Submit({ &ChunkStreamer::generate, &request, 0, 1, &request.Done });
+        }
+    }
+    return changed;
+}
+
+void ChunkStreamer::CollectStars(std::vector<StarVertex>& stars) const
+{
+    MemoryScope scope(MEMORY_SCENE);
+    stars.clear();
+    for (const auto& chunk : this->resident)
+        stars.insert(stars.end(), chunk->Stars.begin(), chunk->Stars.end());
+}
+
+bool ChunkStreamer::isResident(int index) const
+{
+    for (const auto& chunk : this->resident)
+    {
+        if (chunk->Index == index)
+            return true;
+    }
+    return false;
+}
+
+bool ChunkStreamer::isPending(int index) const
+{
+    for (const auto& request : this->pending)
+    {
+        if (request->Chunk.Index == index)
+            return true;
+    }
+    return false;
+}
+
+void ChunkStreamer::insert(std::unique_ptr<DesertChunk> chunk)
+{
+    MemoryScope scope(MEMORY_SCENE);
+    // the objects stay where they are from here on, so the grid can point at them
+    this->scene.Insert(&chunk->Ground, LAYER_BACKGROUND);
+    for (auto& pyramid : chunk->Pyramids)
+        this->scene.Insert(&pyramid, LAYER_PYRAMIDS);
+    for (auto& grass : chunk->Grass)
+        this->scene.Insert(&grass, LAYER_GRASS);
+    this->bytes += chunk->Bytes;
+    this->lastChunkBytes = chunk->Bytes;
+    const auto position = std::lower_bound(this->resident.begin(), this->resident.end(), chunk->Index,
+        [](const std::unique_ptr<DesertChunk>& resident, int index) { return resident->Index < index; });
+    this->resident.insert(position, std::move(chunk));
+}
+
+void ChunkStreamer::evict(size_t position)
+{
+    DesertChunk& chunk = *this->resident[position];
+    this->scene.Remove(&chunk.Ground);
+    for (auto& pyramid : chunk.Pyramids)
+        this->scene.Remove(&pyramid);
+    for (auto& grass : chunk.Grass)
+        this->scene.Remove(&grass);
+    this->bytes -= chunk.Bytes;
+    this->resident.erase(this->resident.begin() + position);
+}
+
+void ChunkStreamer::generate(void* data, size_t, size_t)
+{
+    MemoryScope scope(MEMORY_SCENE);
+    Request& request = *static_cast<Request*>(data);
+    const ChunkSettings& settings = *request.Settings;
+    DesertChunk& chunk = request.Chunk;
+    Random random(settings.Seed, chunkStreamBase + static_cast<unsigned long long>(static_cast<long long>(chunk.Index)));
+    const float width = settings.Size.x, height = settings.Size.y;
+    const float left = static_cast<float>(chunk.Index) * width;
+    const auto below = [](float space) { return static_cast<unsigned int>(std::max(space, 1.0f)); };
+
+    chunk.Ground = GameObject(glm::vec2(left, height / 2.0f), glm::vec2(width, height / 2.0f), settings.Ground);
+    chunk.Pyramids.reserve(settings.PyramidCount);
+    for (unsigned int i = 0; i < settings.PyramidCount; ++i)
+    {
+        const float size = width / 10.0f + random.Int(100);
+        const float x = left + random.Int(below(width - size));
+        const float y = settings.Horizon - size + random.Int(below(height - settings.Horizon - size));
+        chunk.Pyramids.emplace_back(glm::vec2(x, y), glm::vec2(size, size), settings.Pyramid);
+    }
+    chunk.Grass.reserve(settings.GrassCount);
+    for (unsigned int i = 0; i < settings.GrassCount; ++i)
+    {
+        const float size = width / 30.0f + random.Int(below(width / 30.0f));
+        const float x = left + random.Int(below(width - size));
+        const float y = height - size - random.Int(below((height - settings.Horizon) / 2.0f));
+        chunk.Grass.emplace_back(glm::vec2(x, y), glm::vec2(size, size), settings.Grass);
+    }
+    const auto backToFront = [](const GameObject& a, const GameObject& b)
+    {
+        return a.Position.y + a.Size.y < b.Position.y + b.Size.y;
+    };
+    std::sort(chunk.Pyramids.begin(), chunk.Pyramids.end(), backToFront);
+    std::sort(chunk.Grass.begin(), chunk.Grass.end(), backToFront);
+    chunk.Stars.resize(settings.StarCount);
+    for (auto& star : chunk.Stars)
+    {
+        const float x = random.Float(left, left + width);
+        const float y = random.Float(0.0f, settings.Horizon);
+        star.Position = glm::vec2(x, y);
+        star.Size = random.Float(10.0f, 30.0f);
+        star.Phase = random.Float(0.0f, 6.2831853f);
+    }
+    chunk.Bytes = sizeof(DesertChunk) + (chunk.Pyramids.capacity() + chunk.Grass.capacity()) * sizeof(GameObject)
+                + chunk.Stars.capacity() * sizeof(StarVertex);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef CHUNK_STREAMER_H
+#define CHUNK_STREAMER_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game_object.h"
+#include "texture.h"
+#include "render_queue.h"
+#include "job_system.h"
+
+class SpatialGrid;
+
+// what every streamed chunk is built from
+struct ChunkSettings {
+    glm::vec2          Size;            // world units; chunks lie side by side along x
+    float              Horizon;         // world y the desert starts at
+    unsigned int       PyramidCount;
+    unsigned int       GrassCount;
+    unsigned int       StarCount;
+    unsigned long long Seed;
+    Texture2D          Ground, Pyramid, Grass;
+};
+
+// one chunk of desert; plain data, so it can be built on a worker thread
+struct DesertChunk {
+    int                     Index;      // covers [Index * Size.x, (Index + 1) * Size.x)
+    GameObject              Ground;
+    std::vector<GameObject> Pyramids;   // back to front
+    std::vector<GameObject> Grass;      // back to front
+    std::vector<StarVertex> Stars;
+    size_t                  Bytes;      // heap memory it holds, counted against the budget
+};
+
+// Streams an endless row of desert chunks around the camera. Chunks within radius of the
+// visible range are generated on the job system, from the seed and their index alone, so
+// one that was evicted comes back the same. Chunks further away are evicted, and so are the
+// furthest ones whenever the resident chunks hold more than the budget. Chunk 0 is the
+// hand-built scene and is never streamed.
+// A synchronous streamer waits for each chunk it requested and keeps a fixed number of
+// requests in flight, so chunks arrive on the same frames on every run and machine.
+// Not thread-safe: call everything from the thread that updates the game.
+class ChunkStreamer
+{
+public:
+    ChunkStreamer(const ChunkSettings& settings, SpatialGrid& scene, int radius, size_t budget, bool synchronous = false);
+    // waits for the chunks still being generated
+    ~ChunkStreamer();
+    // requests what [minX, maxX] and the radius around it need, takes in finished chunks and
+    // evicts the rest; true when the resident chunks changed
+    bool Update(float minX, float maxX);
+    // ordered by index
+    const std::vector<std::unique_ptr<DesertChunk>>& Resident() const { return this->resident; }
+    size_t Bytes() const { return this->bytes; }
+    // the stars of every resident chunk
+    void   CollectStars(std::vector<StarVertex>& stars) const;
+private:
+    struct Request {
+        const ChunkSettings* Settings;
+        DesertChunk          Chunk;
+        JobCounter           Done;
+    };
+    ChunkSettings                             settings;
+    SpatialGrid&                              scene;
+    int                                       radius;
+    size_t                                    budget;
+    bool                                      synchronous;
+    size_t                                    bytes;
+    size_t                                    lastChunkBytes;   // what the next chunk will likely take
+    std::vector<std::unique_ptr<DesertChunk>> resident;
+    std::vector<std::unique_ptr<Request>>     pending;
+    bool isResident(int index) const;
+    bool isPending(int index) const;
+    void insert(std::unique_ptr<DesertChunk> chunk);
+    void evict(size_t position);
+    static void generate(void* data, size_t begin, size_t end);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "cpu_features.h"
+
+#if defined(CPU_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    bool detectAVX2()
+    {
+#if defined(CPU_X86_SIMD) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        if (!osSavesYmm)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(CPU_X86_SIMD)
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+}
+
+bool CpuFeatures::HasSSE2()
+{
+#if defined(CPU_X86_SIMD)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool CpuFeatures::HasAVX2()
+{
+    static const bool available = detectAVX2();
+    return available;
+}
+
+bool CpuFeatures::HasNEON()
+{
+#if defined(CPU_ARM_NEON)
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CPU_X86_SIMD 1
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define CPU_ARM_NEON 1
+#endif
+
+// GCC and Clang only emit AVX2 instructions inside functions marked for it; MSVC always can
+#if defined(__GNUC__) || defined(__clang__)
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CPU_TARGET_AVX2
+#endif
+
+// instruction sets usable on this machine, detected once at startup
+class CpuFeatures
+{
+public:
+    static bool HasSSE2();
+    static bool HasAVX2();
+    static bool HasNEON();
+private:
+    CpuFeatures() { }
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "entity_batch.h"
+
+#include "game_object.h"
+#include "job_system.h"
+
+void EntityBatch::Add(GameObject* object, glm::vec2 min, glm::vec2 max, float alphaRate)
+{
+    this->objects.push_back(object);
+    this->positionX.push_back(object->Position.x);
+    this->positionY.push_back(object->Position.y);
+    this->velocityX.push_back(object->Velocity.x);
+    this->velocityY.push_back(object->Velocity.y);
+    this->alpha.push_back(object->Alpha);
+    this->alphaRate.push_back(alphaRate);
+    this->minX.push_back(min.x);
+    this->maxX.push_back(max.x);
+    this->minY.push_back(min.y);
+    this->maxY.push_back(max.y);
+}
+
+void EntityBatch::Clear()
+{
+    this->objects.clear();
+    for (auto* stream : { &positionX, &positionY, &velocityX, &velocityY, &alpha, &alphaRate, &minX, &maxX, &minY, &maxY })
+        stream->clear();
+}
+
+void EntityBatch::Update(float dt)
+{
+    const size_t count = this->objects.size();
+    const EntityStreams streams = { positionX.data(), positionY.data(), velocityX.data(), velocityY.data(),
+                                    alpha.data(), alphaRate.data(), minX.data(), maxX.data(), minY.data(), maxY.data(), count };
+    static const UpdatePath best = BestUpdatePath();
+    // other code may have moved or turned the objects since the last frame
+    JobSystem::ParallelFor(count, 4096, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const GameObject* object = this->objects[i];
+            positionX[i] = object->Position.x;
+            positionY[i] = object->Position.y;
+            velocityX[i] = object->Velocity.x;
+            velocityY[i] = object->Velocity.y;
+            alpha[i] = object->Alpha;
+        }
+        UpdateEntities(streams, begin, end, dt, best);
+        for (size_t i = begin; i < end; ++i)
+        {
+            GameObject* object = this->objects[i];
+            object->Position = glm::vec2(positionX[i], positionY[i]);
+            object->Velocity = glm::vec2(velocityX[i], velocityY[i]);
+            object->Alpha = alpha[i];
+        }
+    });
+}
+
+size_t EntityBatch::Size() const
+{
+    return this->objects.size();
+}
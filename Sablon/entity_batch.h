@@ -0,0 +1,29 @@
+#pragma once
+#ifndef ENTITY_BATCH_H
+#define ENTITY_BATCH_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "entity_update.h"
+
+class GameObject;
+
+// Moves GameObjects by their Velocity: gathers them into streams, runs the kernel split over
+// the job system and writes the results back.
+class EntityBatch
+{
+public:
+    // min and max bound the object's Position, not its far edge
+    void   Add(GameObject* object, glm::vec2 min, glm::vec2 max, float alphaRate = 0.0f);
+    void   Clear();
+    void   Update(float dt);
+    size_t Size() const;
+private:
+    std::vector<GameObject*> objects;
+    std::vector<float>       positionX, positionY, velocityX, velocityY, alpha, alphaRate;
+    std::vector<float>       minX, maxX, minY, maxY;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "entity_update.h"
+
+#include <cmath>
+
+#include "cpu_features.h"
+
+#if defined(CPU_X86_SIMD)
+#include <immintrin.h>
+#endif
+#if defined(CPU_ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    void updateScalar(const EntityStreams& e, size_t begin, size_t end, float dt)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const float x = e.PositionX[i] + e.VelocityX[i] * dt;
+            const float y = e.PositionY[i] + e.VelocityY[i] * dt;
+            // the lower bound wins when an entity does not fit between the two
+            if (x < e.MinX[i])
+            {
+                e.PositionX[i] = e.MinX[i];
+                e.VelocityX[i] = std::fabs(e.VelocityX[i]);
+            }
+            else if (x > e.MaxX[i])
+            {
+                e.PositionX[i] = e.MaxX[i];
+                e.VelocityX[i] = -std::fabs(e.VelocityX[i]);
+            }
+            else
+                e.PositionX[i] = x;
+            if (y < e.MinY[i])
+            {
+                e.PositionY[i] = e.MinY[i];
+                e.VelocityY[i] = std::fabs(e.VelocityY[i]);
+            }
+            else if (y > e.MaxY[i])
+            {
+                e.PositionY[i] = e.MaxY[i];
+                e.VelocityY[i] = -std::fabs(e.VelocityY[i]);
+            }
+            else
+                e.PositionY[i] = y;
+            const float alpha = e.Alpha[i] + e.AlphaRate[i] * dt;
+            e.Alpha[i] = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+        }
+    }
+
+#if defined(CPU_X86_SIMD)
+    // SSE2 has no blend, so selects are and/andnot/or
+    inline __m128 select4(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    inline void axis4(float* position, float* velocity, const float* min, const float* max, __m128 dt)
+    {
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        const __m128 v = _mm_loadu_ps(velocity);
+        const __m128 p = _mm_add_ps(_mm_loadu_ps(position), _mm_mul_ps(v, dt));
+        const __m128 lo = _mm_loadu_ps(min), hi = _mm_loadu_ps(max);
+        const __m128 below = _mm_cmplt_ps(p, lo);
+        const __m128 above = _mm_andnot_ps(below, _mm_cmpgt_ps(p, hi));
+        const __m128 speed = _mm_andnot_ps(signBit, v);
+        _mm_storeu_ps(position, select4(below, lo, select4(above, hi, p)));
+        _mm_storeu_ps(velocity, select4(below, speed, select4(above, _mm_or_ps(speed, signBit), v)));
+    }
+
+    size_t updateSSE(const EntityStreams& e, size_t begin, size_t end, float dt)
+    {
+        const __m128 step = _mm_set1_ps(dt);
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            axis4(e.PositionX + i, e.VelocityX + i, e.MinX + i, e.MaxX + i, step);
+            axis4(e.PositionY + i, e.VelocityY + i, e.MinY + i, e.MaxY + i, step);
+            const __m128 alpha = _mm_add_ps(_mm_loadu_ps(e.Alpha + i), _mm_mul_ps(_mm_loadu_ps(e.AlphaRate + i), step));
+            _mm_storeu_ps(e.Alpha + i, _mm_min_ps(_mm_max_ps(alpha, _mm_setzero_ps()), _mm_set1_ps(1.0f)));
+        }
+        return i;
+    }
+
+    CPU_TARGET_AVX2 inline void axis8(float* position, float* velocity, const float* min, const float* max, __m256 dt)
+    {
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+        const __m256 v = _mm256_loadu_ps(velocity);
+        const __m256 p = _mm256_add_ps(_mm256_loadu_ps(position), _mm256_mul_ps(v, dt));
+        const __m256 lo = _mm256_loadu_ps(min), hi = _mm256_loadu_ps(max);
+        const __m256 below = _mm256_cmp_ps(p, lo, _CMP_LT_OQ);
+        const __m256 above = _mm256_cmp_ps(p, hi, _CMP_GT_OQ);
+        const __m256 speed = _mm256_andnot_ps(signBit, v);
+        // blend the upper bound first so the lower one wins, as in the scalar path
+        _mm256_storeu_ps(position, _mm256_blendv_ps(_mm256_blendv_ps(p, hi, above), lo, below));
+        _mm256_storeu_ps(velocity, _mm256_blendv_ps(_mm256_blendv_ps(v, _mm256_or_ps(speed, signBit), above), speed, below));
+    }
+
+    CPU_TARGET_AVX2 size_t updateAVX2(const EntityStreams& e, size_t begin, size_t end, float dt)
+    {
+        const __m256 step = _mm256_set1_ps(dt);
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            axis8(e.PositionX + i, e.VelocityX + i, e.MinX + i, e.MaxX + i, step);
+            axis8(e.PositionY + i, e.VelocityY + i, e.MinY + i, e.MaxY + i, step);
+            const __m256 alpha = _mm256_add_ps(_mm256_loadu_ps(e.Alpha + i), _mm256_mul_ps(_mm256_loadu_ps(e.AlphaRate + i), step));
+            _mm256_storeu_ps(e.Alpha + i, _mm256_min_ps(_mm256_max_ps(alpha, _mm256_setzero_ps()), _mm256_set1_ps(1.0f)));
+        }
+        return i;
+    }
+#endif
+
+#if defined(CPU_ARM_NEON)
+    inline void axisNEON(float* position, float* velocity, const float* min, const float* max, float32x4_t dt)
+    {
+        const float32x4_t v = vld1q_f32(velocity);
+        // separate multiply and add, a fused vmla would round differently from the other paths
+        const float32x4_t p = vaddq_f32(vld1q_f32(position), vmulq_f32(v, dt));
+        const float32x4_t lo = vld1q_f32(min), hi = vld1q_f32(max);
+        const uint32x4_t below = vcltq_f32(p, lo);
+        const uint32x4_t above = vcgtq_f32(p, hi);
+        const float32x4_t speed = vabsq_f32(v);
+        vst1q_f32(position, vbslq_f32(below, lo, vbslq_f32(above, hi, p)));
+        vst1q_f32(velocity, vbslq_f32(below, speed, vbslq_f32(above, vnegq_f32(speed), v)));
+    }
+
+    size_t updateNEON(const EntityStreams& e, size_t begin, size_t end, float dt)
+    {
+        const float32x4_t step = vdupq_n_f32(dt);
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            axisNEON(e.PositionX + i, e.VelocityX + i, e.MinX + i, e.MaxX + i, step);
+            axisNEON(e.PositionY + i, e.VelocityY + i, e.MinY + i, e.MaxY + i, step);
+            const float32x4_t alpha = vaddq_f32(vld1q_f32(e.Alpha + i), vmulq_f32(vld1q_f32(e.AlphaRate + i), step));
+            vst1q_f32(e.Alpha + i, vminq_f32(vmaxq_f32(alpha, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f)));
+        }
+        return i;
+    }
+#endif
+}
+
+UpdatePath BestUpdatePath()
+{
+    if (CpuFeatures::HasAVX2())
+        return UPDATE_AVX2;
+    if (CpuFeatures::HasSSE2())
+        return UPDATE_SSE;
+    if (CpuFeatures::HasNEON())
+        return UPDATE_NEON;
+    return UPDATE_SCALAR;
+}
+
+void UpdateEntities(const EntityStreams& entities, float dt)
+{
+    static const UpdatePath best = BestUpdatePath();
+    UpdateEntities(entities, dt, best);
+}
+
+void UpdateEntities(const EntityStreams& entities, float dt, UpdatePath path)
+{
+    UpdateEntities(entities, 0, entities.Count, dt, path);
+}
+
+void UpdateEntities(const EntityStreams& entities, size_t begin, size_t end, float dt, UpdatePath path)
+{
+    size_t done = begin;
+#if defined(CPU_X86_SIMD)
+    if (path == UPDATE_AVX2 && CpuFeatures::HasAVX2())
+        done = updateAVX2(entities, begin, end, dt);
+    else if (path != UPDATE_SCALAR)
+        done = updateSSE(entities, begin, end, dt);
+#elif defined(CPU_ARM_NEON)
+    if (path != UPDATE_SCALAR)
+        done = updateNEON(entities, begin, end, dt);
+#endif
+    // remainder that does not fill a whole vector
+    updateScalar(entities, done, end, dt);
+}
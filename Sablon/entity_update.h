@@ -0,0 +1,37 @@
+#pragma once
+#ifndef ENTITY_UPDATE_H
+#define ENTITY_UPDATE_H
+
+#include <cstddef>
+
+// structure-of-arrays view of the entities to move, Count entries in every array
+struct EntityStreams {
+    float*       PositionX;
+    float*       PositionY;
+    float*       VelocityX;
+    float*       VelocityY;
+    float*       Alpha;
+    const float* AlphaRate;     // alpha change per second, the result is clamped to [0, 1]
+    const float* MinX;          // position bounds; at a bound the velocity turns back inside
+    const float* MaxX;
+    const float* MinY;
+    const float* MaxY;
+    size_t       Count;
+};
+
+enum UpdatePath {
+    UPDATE_SCALAR,
+    UPDATE_SSE,
+    UPDATE_AVX2,
+    UPDATE_NEON
+};
+
+// position += velocity * dt, then clamp to the bounds and bounce off them the way the fish
+// turns at the lake edges, then fade alpha. All paths give the same results.
+void       UpdateEntities(const EntityStreams& entities, float dt);
+void       UpdateEntities(const EntityStreams& entities, float dt, UpdatePath path);
+// only entries [begin, end), so ranges can be split across threads
+void       UpdateEntities(const EntityStreams& entities, size_t begin, size_t end, float dt, UpdatePath path);
+UpdatePath BestUpdatePath();
+
+#endif
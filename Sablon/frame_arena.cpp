@@ -0,0 +1,81 @@
+#include "frame_arena.h"
+#include "memory_tracker.h"
+
+#include <cstdint>
+#include <cstring>
+
+
+FrameArena::FrameArena(size_t blockSize)
+    : offset(0), usedBefore(0), blockSize(blockSize)
+{
+    this->addBlock(blockSize);
+}
+
+FrameArena::~FrameArena()
+{
+    for (const auto& block : this->blocks)
+        delete[] block.Memory;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    Block* block = &this->blocks.back();
+    uintptr_t address = reinterpret_cast<uintptr_t>(block->Memory) + this->offset;
+    size_t padding = (alignment - address % alignment) % alignment;
+    if (this->offset + padding + size > block->Size)
+    {
+        // overflow for this frame only; Reset() folds everything into one bigger block
+        this->usedBefore += this->offset;
+        this->addBlock(size + alignment);
+        block = &this->blocks.back();
+        address = reinterpret_cast<uintptr_t>(block->Memory);
+        padding = (alignment - address % alignment) % alignment;
+    }
+    this->offset += padding;
+    void* memory = block->Memory + this->offset;
+    this->offset += size;
+    return memory;
+}
+
+char* FrameArena::CopyString(const char* text, size_t length)
+{
+    char* copy = static_cast<char*>(this->Allocate(length + 1, 1));
+    std::memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+void FrameArena::Reset()
+{
+    if (this->blocks.size() > 1)
+    {
+        const size_t needed = this->Capacity();
+        for (const auto& block : this->blocks)
+            delete[] block.Memory;
+        this->blocks.clear();
+        this->addBlock(needed);
+    }
+    this->offset = 0;
+    this->usedBefore = 0;
+}
+
+size_t FrameArena::Used() const
+{
+    return this->usedBefore + this->offset;
+}
+
+size_t FrameArena::Capacity() const
+{
+    size_t capacity = 0;
+    for (const auto& block : this->blocks)
+        capacity += block.Size;
+    return capacity;
+}
+
+void FrameArena::addBlock(size_t minimumSize)
+{
+    MemoryScope scope(MEMORY_FRAME_ARENA);
+    const size_t size = minimumSize > this->blockSize ? minimumSize : this->blockSize;
+    this->blocks.push_back({ new char[size], size });
+    this->offset = 0;
+}
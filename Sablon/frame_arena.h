@@ -0,0 +1,69 @@
+#pragma once
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for data that lives for one frame. Allocation is a pointer increment,
+// Reset() releases everything at once. After a frame that overflowed its block the arena
+// grows to fit, so a steady-state frame never touches the heap.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t blockSize = 64 * 1024);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    void*  Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    // copies a string including its terminator
+    char*  CopyString(const char* text, size_t length);
+    void   Reset();
+    size_t Used() const;
+    size_t Capacity() const;
+private:
+    struct Block {
+        char*  Memory;
+        size_t Size;
+    };
+    std::vector<Block> blocks;
+    size_t             offset;      // into the last block
+    size_t             usedBefore;  // bytes in the full blocks before the last one
+    size_t             blockSize;
+    void addBlock(size_t minimumSize);
+};
+
+// std allocator over a FrameArena; deallocate is a no-op, memory returns on Reset()
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    explicit ArenaAllocator(FrameArena& arena) : arena(&arena) { }
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) { }
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) { }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+    FrameArena* arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -0,0 +1,45 @@
+#include "frame_constants.h"
+
+#include <cstddef>
+
+#include "memory_tracker.h"
+
+FrameConstantsBuffer::FrameConstantsBuffer()
+    : current()
+{
+    glGenBuffers(1, &this->UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frameConstantsBinding, this->UBO);
+    MemoryTracker::TrackBuffer(this->UBO, sizeof(FrameConstants), MEMORY_RENDER_TARGETS);
+}
+
+FrameConstantsBuffer::~FrameConstantsBuffer()
+{
+    glDeleteBuffers(1, &this->UBO);
+    MemoryTracker::UntrackBuffer(this->UBO);
+}
+
+void FrameConstantsBuffer::Update(const FrameConstants& constants)
+{
+    this->current = constants;
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &constants);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameConstantsBuffer::SetProjection(const glm::mat4& projection)
+{
+    this->current.Projection = projection;
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(FrameConstants, Projection), sizeof(glm::mat4), &projection);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameConstantsBuffer::Attach(GLuint program)
+{
+    const GLuint block = glGetUniformBlockIndex(program, "FrameConstants");
+    if (block != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, block, frameConstantsBinding);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef FRAME_CONSTANTS_H
+#define FRAME_CONSTANTS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "render_queue.h"
+
+// uniform block binding point every program's FrameConstants block is attached to
+constexpr GLuint frameConstantsBinding = 0;
+
+// The uniform buffer behind the FrameConstants block the shaders share. It stays bound to
+// frameConstantsBinding and is rewritten once per frame, so no program gets its own matrices.
+class FrameConstantsBuffer
+{
+public:
+    FrameConstantsBuffer();
+    ~FrameConstantsBuffer();
+    void Update(const FrameConstants& constants);
+    // replaces only the projection, for passes drawing into an offscreen target
+    void SetProjection(const glm::mat4& projection);
+    const FrameConstants& Current() const { return this->current; }
+    // points program's FrameConstants block, if it declares one, at the shared buffer
+    static void Attach(GLuint program);
+private:
+    unsigned int   UBO;
+    FrameConstants current;
+};
+
+#endif
@@ -1,17 +1,30 @@
-#include "game.h"
+#include "Game.h"
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <limits>
 
 #include "resource_manager.h"
 #include "sprite_renderer.h"
 #include "game_object.h"
 #include <vector>
-#include <cstdlib> 
-#include <ctime>
 #include <iostream>
 #include <thread>
 
 #include "text_renderer.h"
+#include "job_system.h"
+#include "memory_tracker.h"
+#include "spatial_grid.h"
+#include "layer_cache.h"
+#include "sky_renderer.h"
+#include "star_field.h"
+#include "particle_system.h"
+#include "entity_batch.h"
+#include "random.h"
+#include "render_trace.h"
+#include "frame_constants.h"
+#include "chunk_streamer.h"
+#include "resolution_scaler.h"
 
 using namespace std;
 
@@ -20,18 +33,51 @@ GameObject* Player;
 GameObject* Sun;
 GameObject* Moon;
 GameObject* Desert;
-GameObject* Sky;
 GameObject* Star;
-vector<GameObject*> Stars;
 vector<GameObject*> Grass;
 vector<GameObject*> Pyramids;
 vector<GameObject*> Doors;
 GameObject* Water;
 GameObject* Fish;
 TextRenderer* Text;
+TaskGraph UpdateTasks;
+SpatialGrid* Scene;
+vector<GameObject*> Hits;
+LayerCache* Layers;
+SkyRenderer* SkyPass;
+StarField* Stars;
+ParticleSystem* Particles;
+EntityBatch* Movers;
+RenderTraceWriter* Trace;
+FrameConstantsBuffer* Frame;
+ChunkStreamer* Streamer;
+ResolutionScaler* Scaler;
+vector<StarVertex> StreamedStars;
+// one stream per system, so regenerating the stars does not change the next pyramids
+Random StarRandom;
+Random PyramidRandom;
+Random GrassRandom;
+
+// the desert, pyramids and doors only change on key presses, so they are kept in a texture
+constexpr unsigned int groundLayer = 0;
+constexpr unsigned int cachedLayerCount = 1;
+
+constexpr unsigned long long starStream = 1;
+constexpr unsigned long long pyramidStream = 2;
+constexpr unsigned long long grassStream = 3;
+
+// the sand flies at most about 65 world units a second for 7 seconds past the desert
+constexpr float sandDrift = 500.0f;
+// a twinkle swings star brightness by 0.6 of the visibility; below one 8-bit step it cannot be seen
+constexpr float minTwinkleVisibility = 1.0f / (0.6f * 255.0f);
+
+// world units per second at zoom 1, and doublings of the zoom per second
+constexpr float cameraPanSpeed = 600.0f;
+constexpr float cameraZoomRate = 1.0f;
 
 Game::Game(unsigned int width, unsigned int height)
-    : State(GAME_ACTIVE), Keys(), Width(width), Height(height)
+    : State(GAME_ACTIVE), Keys(), Width(width), Height(height),
+      Camera(glm::vec2(width, height), glm::vec2(width, height))
 {
     
 }
@@ -43,17 +89,24 @@ Game::Game()
 Game::~Game()
 {
     delete Renderer;
+    delete Streamer;
+    delete Scene;
+    delete Layers;
+    delete SkyPass;
+    delete Stars;
+    delete Particles;
+    delete Movers;
+    delete Trace;
+    delete Frame;
+    delete Scaler;
+    delete Text;
     delete Player;
     delete Sun;
     delete Moon;
     delete Desert;
-    delete Sky;
     delete Water;
     delete Fish;
 
-    for (const auto& star : Stars) {
-        delete star;
-    }
     for (const auto& grass : Grass) {
         delete grass;
     }
@@ -63,31 +116,61 @@ Game::~Game()
     for (const auto& door: Doors) {
         delete door;
     }
+    // leave nothing behind, so another game can be initialized after this one
+    Grass.clear();
+    Pyramids.clear();
+    Doors.clear();
+    StreamedStars.clear();
+    Trace = nullptr;
+    Scaler = nullptr;
+    UpdateTasks.Clear();
 }
 
 void Game::Init()
 {
-	// load shaders
-	ResourceManager::LoadShader("sprite.vert", "sprite.frag", nullptr, "sprite");
-	// configure shaders
-	glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(this->Width),
-	                                  static_cast<float>(this->Height), 0.0f, -1.0f, 1.0f);
-	ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
-	ResourceManager::GetShader("sprite").SetMatrix4("projection", projection);
-	// set render-specific controls
-	Renderer = new SpriteRenderer(ResourceManager::GetShader("sprite"));
+    MemoryScope scope(MEMORY_SCENE);
+    StarRandom = Random(Seed, starStream);
+    PyramidRandom = Random(Seed, pyramidStream);
+    GrassRandom = Random(Seed, grassStream);
+	// load shaders; the driver compiles them while the textures and the font load
+	ResourceManager::SubmitShader("sprite.vert", "sprite.frag", nullptr, "sprite");
+	ResourceManager::SubmitShader("sprite.vert", "sprite.frag", nullptr, "sprite highlight", { "HIGHLIGHT" });
+	ResourceManager::SubmitShader("sky.vert", "sky.frag", nullptr, "sky");
+	ResourceManager::SubmitShader("star.vert", "star.frag", nullptr, "star");
+	ResourceManager::SubmitShader("particle.vert", "particle.frag", nullptr, "particle");
+	if (DynamicResolution)
+		ResourceManager::SubmitShader("upscale.vert", "upscale.frag", nullptr, "upscale");
 	// load textures
 	ResourceManager::LoadTexture("res/texel_checker.png", false, "face");
 	ResourceManager::LoadTexture("res/sun.png", true, "sun");
 	ResourceManager::LoadTexture("res/moon.png", true, "moon");
 	ResourceManager::LoadTexture("res/desert.png", true, "desert");
-	ResourceManager::LoadTexture("res/sky.png", true, "sky");
 	ResourceManager::LoadTexture("res/star.png", true, "star");
 	ResourceManager::LoadTexture("res/water_shaped.png", true, "water");
 	ResourceManager::LoadTexture("res/fish.png", true, "fish");
 	ResourceManager::LoadTexture("res/grass.png", true, "grass");
 	ResourceManager::LoadTexture("res/pyramid.png", true, "pyramid");
 	ResourceManager::LoadTexture("res/door.jpg", true, "door");
+	Text = new TextRenderer();
+	Text->Load("fonts/Antonio-Regular.ttf", 24);
+
+	ResourceManager::FinishShaders();
+	// configure shaders; the matrices come from the frame constants
+	Frame = new FrameConstantsBuffer();
+	ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
+	ResourceManager::GetShader("sprite highlight").Use().SetInteger("image", 0);
+	// set render-specific controls
+	Renderer = new SpriteRenderer(ResourceManager::GetShader("sprite"), ResourceManager::GetShader("sprite highlight"));
+	Scene = new SpatialGrid();
+	Layers = new LayerCache(cachedLayerCount);
+	SkyPass = new SkyRenderer(ResourceManager::GetShader("sky"));
+	ResourceManager::GetShader("star").Use().SetInteger("image", 0);
+	Stars = new StarField(ResourceManager::GetShader("star"), ResourceManager::GetTexture("star"));
+	if (DynamicResolution)
+	{
+		ResourceManager::GetShader("upscale").Use().SetInteger("image", 0);
+		Scaler = new ResolutionScaler(ResourceManager::GetShader("upscale"), MinResolutionScale, MaxResolutionScale, TargetFrameTime);
+	}
 
 	Sun = new GameObject(glm::vec2(this->Width - 200.0f, this->Height / 2.0f - 100.0f), glm::vec2(200.0f, 200.0f),
 	                     ResourceManager::GetTexture("sun"));
@@ -95,31 +178,112 @@ void Game::Init()
 	                      ResourceManager::GetTexture("moon"));
 	Desert = new GameObject(glm::vec2(0.0f, Height / 2), glm::vec2(Width, Height / 2),
 	                        ResourceManager::GetTexture("desert"));
-	Sky = new GameObject(glm::vec2(0.0f, 0.0f), glm::vec2(Width, Height), ResourceManager::GetTexture("sky"));
 	Water = new GameObject(glm::vec2(Width / 1.5f, Height / 1.2f), glm::vec2(Width / 3, Width / 10),
 	                       ResourceManager::GetTexture("water"), glm::vec3(1.0f), glm::vec2(0.0f, 0.0f), 0.7f);
+	Scene->Insert(Desert, LAYER_BACKGROUND);
+	Scene->Insert(Sun, LAYER_CELESTIAL);
+	Scene->Insert(Moon, LAYER_CELESTIAL);
+	Scene->Insert(Water, LAYER_WATER);
 	_initializeStars();
 	_initializePyramids();
 	_initializeGrass();
 	Fish = new GameObject(glm::vec2(Width / 1.45f, Height / 1.1f), glm::vec2(Width / 30, Width / 30),
-	                      ResourceManager::GetTexture("fish"));
-    Text = new TextRenderer(Width, Height);
-    Text->Load("fonts/Antonio-Regular.ttf", 24);
+	                      ResourceManager::GetTexture("fish"), glm::vec3(1.0f), glm::vec2(-100.0f, 0.0f));
+	Scene->Insert(Fish, LAYER_FISH);
+	// the fish swims between the lake edges, minus a tenth of the lake on each side
+	const float padding = Water->Size.x / 10.0f;
+	Movers = new EntityBatch();
+	Movers->Add(Fish, glm::vec2(Water->Position.x + padding, Fish->Position.y),
+	            glm::vec2(Water->Position.x + Water->Size.x - padding - Fish->Size.x, Fish->Position.y));
+	_initializeParticles();
+	// the desert goes on to both sides in chunks the size of this scene, streamed around the camera
+	const ChunkSettings chunks = { glm::vec2(Width, Height), _getSunRiseHeightPoint(), PyramidCount, GrassCount / 3, StarCount, Seed,
+	                               ResourceManager::GetTexture("desert"), ResourceManager::GetTexture("pyramid"), ResourceManager::GetTexture("grass") };
+	Streamer = new ChunkStreamer(chunks, *Scene, ChunkRadius, ChunkBudget, DeterministicStreaming);
+	Camera.SetBounds(glm::vec2(std::numeric_limits<float>::lowest(), 0.0f),
+	                 glm::vec2(std::numeric_limits<float>::max(), static_cast<float>(Height)));
+    _buildUpdateTasks();
+    if (TracePath)
+    {
+        std::vector<TraceTexture> textures;
+        for (const auto& texture : ResourceManager::Textures)
+            textures.push_back({ texture.second.ID, texture.second.Width, texture.second.Height });
+        Trace = new RenderTraceWriter();
+        Trace->Open(TracePath, Width, Height, textures);
+    }
 }
 
 void Game::Update(float dt)
 {
-    _updateSunAndMoon(dt);
-    _updateSkyBrightness(dt);
-    _moveFish(dt);
-    if(_startOpeningDoors)
+    _frameTime = dt;
+    // the grid is not thread-safe, so chunks come and go before the update tasks run
+    if (Streamer->Update(Camera.VisibleMin().x, Camera.VisibleMax().x))
     {
-        _openDoors(dt);
-    }
+        Streamer->CollectStars(StreamedStars);
+        Stars->SetStreamed(StreamedStars);
+        _redraw = true;
+    }
+    UpdateTasks.Run();
+    // the fish swims, the sand blows and the stars twinkle even with time paused, so they
+    // change the picture whenever they are on screen; with nothing else moving that change
+    // only asks for an ambient frame, which the loop draws at a lower rate
+    const glm::vec2 viewMin = Camera.VisibleMin(), viewMax = Camera.VisibleMax();
+    const auto onScreen = [&](const GameObject* object, float padding)
+    {
+        return object->Position.x - padding < viewMax.x && object->Position.x + object->Size.x + padding > viewMin.x
+            && object->Position.y - padding < viewMax.y && object->Position.y + object->Size.y + padding > viewMin.y;
+    };
+    const bool starsTwinkle = (1.0f - _daylight) >= minTwinkleVisibility;
+    const bool sandBlows = ParticleCount > 0 && onScreen(Desert, sandDrift);
+    // the fish and its ripples stay inside the lake
+    const bool fishSwims = onScreen(Water, 0.0f);
+    if (_timeSpeed > 0.0f || _cameraMoved || _doorsOpening)
+        _redraw = true;
+    else if (fishSwims || sandBlows || starsTwinkle)
+        _ambientRedraw = true;
+}
+
+bool Game::NeedsRedraw() const
+{
+    return _redraw || _ambientRedraw;
+}
+
+bool Game::AmbientOnly() const
+{
+    return !_redraw && _ambientRedraw;
+}
+
+void Game::Invalidate()
+{
+    _redraw = true;
+}
+
+void Game::_buildUpdateTasks()
+{
+    // the sun and moon stay above the camera and the sky depends on where the sun is,
+    // everything else is independent
+    const auto camera = UpdateTasks.Add([this] { _moveCamera(_frameTime); });
+    const auto sunAndMoon = UpdateTasks.Add([this] { _updateSunAndMoon(_frameTime); }, { camera });
+    UpdateTasks.Add([this] { _updateSkyBrightness(_frameTime); }, { sunAndMoon });
+    const auto fish = UpdateTasks.Add([this] { _moveFish(_frameTime); });
+    UpdateTasks.Add([this]
+    {
+        _doorsOpening = _startOpeningDoors && _openDoors(_frameTime);
+    });
+    // the grid is not thread-safe, so whatever moved is re-filed once the movers are done
+    UpdateTasks.Add([]
+    {
+        Scene->Refresh(Sun);
+        Scene->Refresh(Moon);
+        Scene->Refresh(Fish);
+    }, { sunAndMoon, fish });
 }
 
 void Game::ProcessInput(int key)
 {
+    // every key handled here changes the scene or how it is shown
+    if (key != 0)
+        _redraw = true;
     if (key == GLFW_KEY_R) {
         _sunAngle = 180.0f;
         _timeSpeed = 50.0f;
@@ -134,12 +298,21 @@ void Game::ProcessInput(int key)
     }
     if (key == GLFW_KEY_F)
     {
+        Fish->Velocity.x = -Fish->Velocity.x;
         Fish->FlipHorizontally();
     }
     if (key == GLFW_KEY_3)
     {
         _initializePyramids();
     }
+    if (key == GLFW_KEY_C)
+    {
+        _printCullStats = !_printCullStats;
+    }
+    if (key == GLFW_KEY_HOME)
+    {
+        Camera.Reset();
+    }
     if (key == GLFW_KEY_O)
     {
         _toggleDoorVisibility();
@@ -160,6 +333,7 @@ void Game::ProcessInput(int key)
         if (largestPyramid->Threshold > 1.0f) {
             largestPyramid->Threshold = 1.0f;
         }
+        _redraw = true;
     }
     if (Keys[GLFW_KEY_A])
     {
@@ -168,16 +342,27 @@ void Game::ProcessInput(int key)
         if (largestPyramid->Threshold < 0.0f) {
             largestPyramid->Threshold = 0.0f;
         }
+        _redraw = true;
     }
 }
 
+void Game::Resize(int width, int height)
+{
+    Camera.SetViewport(glm::vec2(width, height));
+    _redraw = true;
+}
+
 void Game::ProcessMouseClick(double x, double y)
 {
-    for (const auto& door : Doors)
+    const glm::vec2 point = Camera.ScreenToWorld(glm::vec2(x, y));
+    Hits.clear();
+    Scene->QueryPoint(point, LAYER_DOORS, Hits);
+    for (const auto& door : Hits)
     {
-	    if(door->Alpha == 1.0f && door->Position.x <= x && door->Position.x + door->Size.x >= x && door->Position.y <= y && door->Position.y + door->Size.y >= y)
+	    if (door->Alpha == 1.0f && door->Contains(point))
 	    {
 		    _isDisplayedToBeContinued = true;
+            _redraw = true;
             break;
 	    }
     }
@@ -185,26 +370,39 @@ void Game::ProcessMouseClick(double x, double y)
 
 bool Game::Render()
 {
-    Sky->Draw(*Renderer);
-
-    for (const auto& star : Stars)
-    {
-        star->Draw(*Renderer);
-    }
+    _redraw = false;
+    _ambientRedraw = false;
+    SkyPass->Draw({ _daylight, _getSunRiseHeightPoint(), Sun->Position + 0.5f * Sun->Size });
+    Stars->Draw(1.0f - _daylight);
 
     Sun->Draw(*Renderer);
     Moon->Draw(*Renderer);
+    CommandBuffer* commands = Renderer->Recording();
+    if (commands)
+        commands->BeginLayer(groundLayer);
     Desert->Draw(*Renderer);
+    for (const auto& chunk : Streamer->Resident())
+        chunk->Ground.Draw(*Renderer);
     for (size_t i = 0; i < Pyramids.size(); ++i)
     {
         Pyramids[i]->Draw(*Renderer);
         Doors[i]->Draw(*Renderer);
     }
+    for (const auto& chunk : Streamer->Resident())
+    {
+        for (auto& pyramid : chunk->Pyramids)
+            pyramid.Draw(*Renderer);
+    }
+    if (commands)
+        commands->EndLayer();
     Fish->Draw(*Renderer);
     Water->Draw(*Renderer);
-    for (const auto& grass: Grass)
+    Particles->Draw(_frameTime);
+    _drawAll(Grass);
+    for (const auto& chunk : Streamer->Resident())
     {
-        grass->Draw(*Renderer);
+        for (auto& grass : chunk->Grass)
+            grass.Draw(*Renderer);
     }
     Text->RenderText("Ognjen Gligoric SV79/2021", Width/30, Height/30, 1.0f);
 
@@ -212,7 +410,10 @@ bool Game::Render()
     {
 	    Text->RenderText("To be continued in 3D game", Width / 2, Height / 4, 3.0f,glm::vec3(1),1.0f, _toBeContinuedThreshold);
         _toBeContinuedThreshold += 0.01;
-        
+        // keep drawing until the text has faded in
+        if (_toBeContinuedThreshold < 0.99f)
+            _redraw = true;
+
         if (_toBeContinuedThreshold >= 0.99f && _toBeContinuedThreshold <= 2.0f)
         {
             _shouldClose = true;
@@ -227,10 +428,153 @@ bool Game::Render()
     return false;
 }
 
+bool Game::Record(CommandBuffer& commands)
+{
+    SkyPass->Begin(commands);
+    Stars->Begin(commands);
+    Particles->Begin(commands);
+    Renderer->Begin(commands);
+    Text->Begin(commands);
+    const bool shouldClose = Render();
+    SkyPass->End();
+    Stars->End();
+    Particles->End();
+    Renderer->End();
+    Text->End();
+    commands.Frame = { Camera.Projection(), Camera.View(), Camera.Viewport(), _skyTime, _sunAngle };
+    if (Trace)
+        Trace->WriteFrame(commands);
+    Culled = CullSprites(commands, Camera.VisibleMin(), Camera.VisibleMax());
+    if (_printCullStats)
+    {
+        cout << "culled " << Culled.Submitted - Culled.Visible << " of " << Culled.Submitted << " sprites: "
+             << Culled.Transparent << " transparent, " << Culled.Offscreen << " offscreen, "
+             << Culled.Occluded << " occluded\n";
+    }
+    return shouldClose;
+}
+
+void Game::Execute(const CommandBuffer& commands)
+{
+    FrameConstants constants = commands.Frame;
+    if (Scaler)
+    {
+        // the scene goes to the scaled target, point sizes follow its pixels
+        Scaler->Begin(constants.ViewportSize);
+        constants.ViewportSize = Scaler->Size();
+    }
+    Frame->Update(constants);
+    bool resolved = Scaler == nullptr;
+    size_t i = 0;
+    while (i < commands.Commands.size())
+    {
+        const RenderCommand& command = commands.Commands[i];
+        if (command.Type == RENDER_TEXT)
+        {
+            // text comes last and stays sharp at the window's own resolution
+            if (!resolved)
+            {
+                Scaler->Resolve();
+                resolved = true;
+            }
+            Text->Execute(commands.Texts[command.Index]);
+            ++i;
+            continue;
+        }
+        if (command.Type == RENDER_SKY)
+        {
+            SkyPass->Execute(commands.Skies[command.Index]);
+            ++i;
+            continue;
+        }
+        if (command.Type == RENDER_STARS)
+        {
+            Stars->Execute(commands.StarFields[command.Index]);
+            ++i;
+            continue;
+        }
+        if (command.Type == RENDER_PARTICLES)
+        {
+            Particles->Execute(commands.ParticleSystems[command.Index]);
+            ++i;
+            continue;
+        }
+        if (command.Type == RENDER_LAYER_BEGIN)
+        {
+            // layers only bracket sprite commands, which index consecutive sprites
+            size_t end = i + 1;
+            while (commands.Commands[end].Type != RENDER_LAYER_END)
+                ++end;
+            const SpriteCommand* sprites = end > i + 1 ? &commands.Sprites[commands.Commands[i + 1].Index] : nullptr;
+            _drawLayer(command.Index, sprites, end - i - 1);
+            i = end + 1;
+            continue;
+        }
+        // consecutive sprite commands index consecutive sprites, draw them as one batch
+        size_t end = i + 1;
+        while (end < commands.Commands.size() && commands.Commands[end].Type == RENDER_SPRITE)
+            ++end;
+        Renderer->DrawBatch(&commands.Sprites[command.Index], end - i);
+        i = end;
+    }
+    if (Scaler)
+    {
+        if (!resolved)
+            Scaler->Resolve();
+        Scaler->End();
+    }
+}
+
+void Game::_drawLayer(unsigned int layer, const SpriteCommand* sprites, size_t count) const
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const glm::mat4 projection = Frame->Current().Projection;
+    const glm::mat4 view = Frame->Current().View;
+    if (Layers->NeedsUpdate(layer, sprites, count, viewport[2], viewport[3], view))
+    {
+        // render upside down so the layer's first texture row is the top of the screen,
+        // the way the composite quad samples it
+        Frame->SetProjection(glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f)) * projection);
+        Layers->BeginUpdate(layer);
+        Renderer->DrawBatch(sprites, count);
+        Layers->EndUpdate();
+        Frame->SetProjection(projection);
+    }
+    // the layer covers the whole viewport, so the quad covers all the world that is visible
+    const glm::mat4 toWorld = glm::inverse(projection * view);
+    const glm::vec2 topLeft(toWorld * glm::vec4(-1.0f, 1.0f, 0.0f, 1.0f));
+    const glm::vec2 bottomRight(toWorld * glm::vec4(1.0f, -1.0f, 0.0f, 1.0f));
+    const SpriteCommand composite = { Layers->Texture(layer), topLeft, bottomRight - topLeft, 0.0f,
+                                      glm::vec3(1.0f), 1.0f, false, 0.0f, glm::vec3(0.0f) };
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    Renderer->DrawBatch(&composite, 1);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void Game::_drawAll(const std::vector<GameObject*>& objects) const
+{
+    CommandBuffer* commands = Renderer->Recording();
+    if (!commands)
+    {
+        for (const auto& object : objects)
+        {
+            object->Draw(*Renderer);
+        }
+        return;
+    }
+    // recording only copies state, so large layers are filled in parallel
+    SpriteCommand* sprites = commands->AllocateSprites(objects.size());
+    JobSystem::ParallelFor(objects.size(), 4096, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            sprites[i] = objects[i]->ToCommand();
+    });
+}
 
 void Game::_updateSunAndMoon(float dt)
 {
-	const auto circleCenter = glm::vec2(this->Width / 2.0f, _getSunRiseHeightPoint()); 
+	const auto circleCenter = glm::vec2(Camera.Position.x, _getSunRiseHeightPoint());
 
     _sunAngle += _timeSpeed * dt;       
 
@@ -247,59 +591,63 @@ void Game::_updateSunAndMoon(float dt)
     Moon->Position.y = circleCenter.y + _getSunRotationRadius() * sin(moonRadians);
 }
 
-void Game::_updateSkyBrightness(float dt) const
+void Game::_updateSkyBrightness(float dt)
 {
+    // the sky shader blends night into day and the star field fades out from this
     float normalizedHeight = (_getSunRiseHeightPoint() - Sun->Position.y) / _getSunRotationRadius();
-    normalizedHeight = glm::clamp(normalizedHeight, 0.0f, 1.0f);
-
-    const glm::vec3 darkestColor = glm::vec3(0.0f, 0.0f, 0.3f); // Midnight blue
-    const glm::vec3 brightestColor = glm::vec3(0.5f, 0.7f, 1.0f); // Sky blue
-
-    const glm::vec3 currentColor = glm::mix(darkestColor, brightestColor, normalizedHeight);
-
-    Sky->Color = currentColor;
-    const float starVisibility = 1.0f - normalizedHeight; 
-    for (const auto& star : Stars) {
-        star->Alpha = starVisibility;
-    }
+    _daylight = glm::clamp(normalizedHeight, 0.0f, 1.0f);
+    _skyTime += dt;
 }
 
-void Game::_initializeStars() const
+void Game::_initializeStars()
 {
-    srand(static_cast<unsigned>(std::time(nullptr)));
-    constexpr int starCount = 50;
-
-    while (Stars.size() < starCount) {
-        Stars.push_back(new GameObject(glm::vec2(0.0f, 0.0f), glm::vec2(0.0f, 0.0f), ResourceManager::GetTexture("star")));
-    }
+    Stars->Generate(StarRandom, StarCount, glm::vec2(0.0f, 0.0f), glm::vec2(Width, _getSunRiseHeightPoint()), 10.0f, 30.0f);
+}
 
-    for (int i = 0; i < starCount; ++i) {
-        const auto x = static_cast<float>(rand() % Width);
-        const auto y = static_cast<float>(rand() % static_cast<int>(_getSunRiseHeightPoint()));
-        const auto size = static_cast<float>(10 + rand() % 21);
-        Stars[i]->Position = glm::vec2(x, y);
-        Stars[i]->Size = glm::vec2(size, size);
-        Stars[i]->Alpha = 1.0f; 
+void Game::_initializeParticles()
+{
+    MemoryScope scope(MEMORY_PARTICLES);
+    const bool compute = ComputeParticles && ParticleSystem::ComputeAvailable();
+    if (compute)
+    {
+        ResourceManager::LoadComputeShader("particle_update.comp", "particle update");
     }
+    else
+    {
+        const char* varyings[] = { "outMotion", "outLife" };
+        ResourceManager::LoadFeedbackShader("particle_update.vert", varyings, 2, "particle update");
+    }
+    Particles = new ParticleSystem(ResourceManager::GetShader("particle"), ResourceManager::GetShader("particle update"),
+                                   compute, ParticleCount);
+
+    // sand blown across the upper desert, ripples spreading where the fish swims
+    const unsigned int rippleCount = ParticleCount / 10;
+    Particles->AddEmitter(Desert, { glm::vec4(0.0f, 0.05f, 1.0f, 0.6f), glm::vec2(40.0f, -5.0f), glm::vec2(25.0f, 8.0f),
+                                    glm::vec2(3.0f, 7.0f), glm::vec2(2.0f, 3.0f), glm::vec4(0.93f, 0.8f, 0.55f, 0.6f),
+                                    ParticleCount - rippleCount });
+    Particles->AddEmitter(Fish, { glm::vec4(0.2f, 0.7f, 0.8f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(12.0f, 4.0f),
+                                  glm::vec2(0.8f, 1.6f), glm::vec2(2.0f, 10.0f), glm::vec4(0.85f, 0.95f, 1.0f, 0.35f),
+                                  rippleCount });
 }
 
 void Game::_initializePyramids()
 {
-    srand(static_cast<unsigned>(std::time(nullptr)));
-    constexpr int pyramidCount = 3;
+    MemoryScope scope(MEMORY_SCENE);
+    const unsigned int pyramidCount = PyramidCount;
 
     while (Pyramids.size() < pyramidCount) {
         Pyramids.push_back(new GameObject(glm::vec2(0.0f, 0.0f), glm::vec2(0.0f, 0.0f), ResourceManager::GetTexture("pyramid")));
     }
 
-    for (int i = 0; i < pyramidCount; ++i) {
-        const auto size = static_cast<float>(Width) / 10 + rand() % 100;
-        const auto x = static_cast<float>(rand() % Width/2);
-        const auto y = _getSunRiseHeightPoint() - size + rand() % static_cast<int>(Height - _getSunRiseHeightPoint() - size);
+    for (unsigned int i = 0; i < pyramidCount; ++i) {
+        const auto size = static_cast<float>(Width) / 10 + PyramidRandom.Int(100);
+        const auto x = static_cast<float>(PyramidRandom.Int(Width / 2));
+        const auto y = _getSunRiseHeightPoint() - size + PyramidRandom.Int(static_cast<unsigned int>(Height - _getSunRiseHeightPoint() - size));
         Pyramids[i]->Position = glm::vec2(x, y);
         Pyramids[i]->Size = glm::vec2(size, size);
         Pyramids[i]->Alpha = 1.0f;
         Pyramids[i]->Threshold = 0.0f;
+        Scene->Insert(Pyramids[i], LAYER_PYRAMIDS);
     }
 
     std::sort(Pyramids.begin(), Pyramids.end(), [](const GameObject* a, const GameObject* b)
@@ -310,22 +658,23 @@ void Game::_initializePyramids()
     _initializeDoors();
 }
 
-void Game::_initializeGrass() const
+void Game::_initializeGrass()
 {
-    srand(static_cast<unsigned>(std::time(nullptr)));
-    constexpr int grassCount = 30;
+    MemoryScope scope(MEMORY_SCENE);
+    const unsigned int grassCount = GrassCount;
 
     while (Grass.size() < grassCount) {
         Grass.push_back(new GameObject(glm::vec2(0.0f, 0.0f), glm::vec2(0.0f, 0.0f), ResourceManager::GetTexture("grass")));
     }
 
-    for (int i = 0; i < grassCount; ++i) {
-        const auto size = static_cast<float>(Width) / 15 + rand() % 200;
-        const auto x = Water->Position.x - size/2 + rand() % static_cast<int>(Water->Size.x);
-        const auto y = Water->Position.y + Water->Size.y - size +  (rand() % static_cast<int>(Width/30) - Width/60);
+    for (unsigned int i = 0; i < grassCount; ++i) {
+        const auto size = static_cast<float>(Width) / 15 + GrassRandom.Int(200);
+        const auto x = Water->Position.x - size/2 + GrassRandom.Int(static_cast<unsigned int>(Water->Size.x));
+        const auto y = Water->Position.y + Water->Size.y - size + (static_cast<float>(GrassRandom.Int(Width/30)) - Width/60);
         Grass[i]->Position = glm::vec2(x, y);
         Grass[i]->Size = glm::vec2(size, size);
         Grass[i]->Alpha = 1.0f;
+        Scene->Insert(Grass[i], LAYER_GRASS);
     }
 
     std::sort(Grass.begin(), Grass.end(), [](const GameObject* a, const GameObject* b)
@@ -336,27 +685,36 @@ void Game::_initializeGrass() const
 
 void Game::_moveFish(float dt)
 {
-    const float fishSpeed = 100.0f ; 
-    const float padding = Water->Size.x / 10.0f;
-
-    float waterLeft = Water->Position.x + padding;
-    float waterRight = Water->Position.x + Water->Size.x - padding;
-
-    if (Fish->Position.x + Fish->Size.x > waterRight) {
-        Fish->FlipHorizontally();
-        Fish->Position.x = waterRight - Fish->Size.x; 
-    }
-    else if (Fish->Position.x <= waterLeft) {
-        Fish->FlipHorizontally();
-        Fish->Position.x = waterLeft; 
-    }
+    Movers->Update(dt);
+    // the sprite faces left, so it is flipped whenever the fish swims right
+    Fish->IsFlippedHorizontally = Fish->Velocity.x > 0.0f;
+}
 
-    if (!Fish->IsFlippedHorizontally) {
-        Fish->Position.x -= fishSpeed * dt; 
-    }
-    else {
-        Fish->Position.x += fishSpeed * dt;
-    }
+void Game::_moveCamera(float dt)
+{
+    // arrows pan at the same speed on screen whatever the zoom, + and - zoom around the center
+    const glm::vec2 position = Camera.Position;
+    const float previousZoom = Camera.Zoom;
+    const float step = cameraPanSpeed * dt / Camera.Zoom;
+    glm::vec2 pan(0.0f, 0.0f);
+    if (Keys[GLFW_KEY_LEFT])
+        pan.x -= step;
+    if (Keys[GLFW_KEY_RIGHT])
+        pan.x += step;
+    if (Keys[GLFW_KEY_UP])
+        pan.y -= step;
+    if (Keys[GLFW_KEY_DOWN])
+        pan.y += step;
+    if (pan.x != 0.0f || pan.y != 0.0f)
+        Camera.Pan(pan);
+    float zoom = 1.0f;
+    if (Keys[GLFW_KEY_EQUAL] || Keys[GLFW_KEY_KP_ADD])
+        zoom *= std::exp2(cameraZoomRate * dt);
+    if (Keys[GLFW_KEY_MINUS] || Keys[GLFW_KEY_KP_SUBTRACT])
+        zoom /= std::exp2(cameraZoomRate * dt);
+    if (zoom != 1.0f)
+        Camera.ZoomBy(zoom, 0.5f * Camera.Viewport());
+    _cameraMoved = Camera.Position != position || Camera.Zoom != previousZoom;
 }
 
 void Game::_toggleGrassVisibility()
@@ -386,6 +744,12 @@ auto Game::GetLargestPyramid() const -> GameObject*
 
 void Game::_initializeDoors() const
 {
+    MemoryScope scope(MEMORY_SCENE);
+    for (const auto& door : Doors)
+    {
+        Scene->Remove(door);
+        delete door;
+    }
     Doors.clear(); 
     Doors.shrink_to_fit();
     for (const auto& pyramid : Pyramids)
@@ -397,6 +761,7 @@ void Game::_initializeDoors() const
         door->Alpha = 0.0f;
         door->Rotation = 270.0f;
         door->HighlightColor = glm::vec3(0.0f, 0.0f, 0.0f);
+        Scene->Insert(door, LAYER_DOORS);
     }
 }
 
@@ -413,13 +778,16 @@ void Game::_toggleDoorVisibility()
     }
 }
 
-auto Game::_openDoors(float dt) -> void
+auto Game::_openDoors(float dt) -> bool
 {
+    bool opening = false;
     for (const auto& door : Doors)
     {
+        opening = opening || door->Threshold < 1.0f;
         door->Threshold += 0.01f;
         if (door->Threshold > 1.0f) {
             door->Threshold = 1.0f; 
         }
     }
+    return opening;
 }
@@ -1,5 +1,9 @@
 #include "game_object.h"
 
+#include <cmath>
+
+#include "resource_manager.h"
+
 
 GameObject::GameObject()
     : Position(0.0f, 0.0f),
@@ -43,6 +47,40 @@ void GameObject::Draw(SpriteRenderer& renderer)
 		this->HighlightColor);
 }
 
+SpriteCommand GameObject::ToCommand() const
+{
+    return { this->Sprite.ID,
+		this->Position,
+		this->Size,
+		this->Rotation,
+		this->Color, this->Alpha,
+		this->IsFlippedHorizontally,
+		this->Threshold,
+		this->HighlightColor };
+}
+
+bool GameObject::Contains(glm::vec2 point) const
+{
+    if (this->Size.x == 0.0f || this->Size.y == 0.0f)
+        return false;
+    // undo the rotation around the center that SpriteRenderer applies, then the flip
+    const glm::vec2 offset = point - (this->Position + 0.5f * this->Size);
+    float c = 1.0f, s = 0.0f;
+    if (this->Rotation != 0.0f)
+    {
+        const float radians = glm::radians(this->Rotation);
+        c = std::cos(radians);
+        s = std::sin(radians);
+    }
+    float u = (c * offset.x + s * offset.y) / this->Size.x;
+    const float v = (c * offset.y - s * offset.x) / this->Size.y + 0.5f;
+    u = this->IsFlippedHorizontally ? 0.5f - u : 0.5f + u;
+    if (u < 0.0f || u >= 1.0f || v < 0.0f || v >= 1.0f)
+        return false;
+    const AlphaMask* mask = ResourceManager::GetAlphaMask(this->Sprite.ID);
+    return !mask || mask->Test(u, v);
+}
+
 void GameObject::FlipHorizontally()
 {
     IsFlippedHorizontally = !IsFlippedHorizontally;
@@ -24,6 +24,9 @@ public:
     GameObject();
     GameObject(glm::vec2 pos, glm::vec2 size, Texture2D sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f), float alpha = 1.0f, float threshold = 0.0f, glm::vec3 highlightColor = glm::vec3(1.0f, 0.0f, 0.0f));
     virtual void Draw(SpriteRenderer& renderer);
+    SpriteCommand ToCommand() const;
+    // whether point lands on an opaque texel of the sprite as drawn, rotation and flip included
+    bool Contains(glm::vec2 point) const;
     void FlipHorizontally();
 };
 
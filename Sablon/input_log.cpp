@@ -0,0 +1,87 @@
+#include "input_log.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    const char     magic[4] = { 'E', 'G', 'I', 'N' };
+    const uint32_t version = 1;
+    static_assert(sizeof(InputEvent) == 16, "InputEvent is written to the log as is");
+}
+
+bool InputLog::Record(const char* path, uint64_t seed)
+{
+    this->output.open(path, std::ios::binary | std::ios::trunc);
+    if (!this->output)
+    {
+        std::cout << "ERROR::INPUT_LOG: Failed to create " << path << std::endl;
+        return false;
+    }
+    this->Seed = seed;
+    this->output.write(magic, sizeof(magic));
+    this->output.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    this->output.write(reinterpret_cast<const char*>(&seed), sizeof(seed));
+    return true;
+}
+
+void InputLog::Write(const InputEvent& event)
+{
+    if (!this->output.is_open())
+        return;
+    InputEvent stamped = event;
+    stamped.Frame = this->frame;
+    this->output.write(reinterpret_cast<const char*>(&stamped), sizeof(stamped));
+    if (event.Type == INPUT_FRAME)
+        this->frame++;
+}
+
+void InputLog::Close()
+{
+    if (this->output.is_open())
+        this->output.close();
+}
+
+bool InputLog::Recording() const
+{
+    return this->output.is_open();
+}
+
+bool InputLog::Replay(const char* path)
+{
+    std::ifstream input(path, std::ios::binary);
+    char fileMagic[4] = {};
+    uint32_t fileVersion = 0;
+    input.read(fileMagic, sizeof(fileMagic));
+    input.read(reinterpret_cast<char*>(&fileVersion), sizeof(fileVersion));
+    input.read(reinterpret_cast<char*>(&this->Seed), sizeof(this->Seed));
+    if (!input || std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || fileVersion != version)
+    {
+        std::cout << "ERROR::INPUT_LOG: " << path << " is not an input log" << std::endl;
+        return false;
+    }
+    InputEvent event;
+    while (input.read(reinterpret_cast<char*>(&event), sizeof(event)))
+        this->events.push_back(event);
+    this->cursor = 0;
+    this->replaying = true;
+    return true;
+}
+
+bool InputLog::Replaying() const
+{
+    return this->replaying;
+}
+
+bool InputLog::Next(uint32_t frame, InputEvent& event)
+{
+    if (this->cursor >= this->events.size() || this->events[this->cursor].Frame != frame)
+        return false;
+    event = this->events[this->cursor++];
+    return true;
+}
+
+bool InputLog::Ended() const
+{
+    return this->replaying && this->cursor >= this->events.size();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+enum InputEventType : uint8_t {
+    INPUT_FRAME,    // ends a frame's events, X holds its delta time
+    INPUT_KEY,      // Key and Action as GLFW passed them
+    INPUT_CLICK     // left click at (X, Y)
+};
+
+struct InputEvent {
+    uint32_t       Frame;
+    InputEventType Type;
+    uint8_t        Action;
+    uint16_t       Key;
+    float          X, Y;
+};
+
+// Binary log of the input a run received, 16 bytes per event after a header holding the
+// scene seed. Replaying a log feeds the game the same events and delta times at the same
+// frames, so two runs of one log do exactly the same work.
+class InputLog
+{
+public:
+    bool     Record(const char* path, uint64_t seed);
+    // stamps the event with the current frame; an INPUT_FRAME event moves on to the next one
+    void     Write(const InputEvent& event);
+    void     Close();
+    bool     Recording() const;
+    // reads the whole log; Seed is valid afterwards
+    bool     Replay(const char* path);
+    bool     Replaying() const;
+    // the next event recorded for frame, false once the frame's events are used up
+    bool     Next(uint32_t frame, InputEvent& event);
+    // whether every recorded frame has been replayed
+    bool     Ended() const;
+    uint64_t Seed = 0;
+private:
+    std::ofstream           output;
+    std::vector<InputEvent> events;
+    uint32_t                frame = 0;      // being recorded
+    size_t                  cursor = 0;     // next event to replay
+    bool                    replaying = false;
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "job_system.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    constexpr size_t queueCapacity = 4096;
+
+    // fixed-size ring; the owner works at the back, thieves take from the front
+    struct WorkQueue {
+        std::mutex Lock;
+        Job        Jobs[queueCapacity];
+        size_t     Head = 0;
+        size_t     Tail = 0;
+
+        bool Push(const Job& job)
+        {
+            std::lock_guard<std::mutex> guard(Lock);
+            if (Tail - Head == queueCapacity)
+                return false;
+            Jobs[Tail++ % queueCapacity] = job;
+            return true;
+        }
+        bool Pop(Job& job)
+        {
+            std::lock_guard<std::mutex> guard(Lock);
+            if (Tail == Head)
+                return false;
+            job = Jobs[--Tail % queueCapacity];
+            return true;
+        }
+        bool Steal(Job& job)
+        {
+            std::lock_guard<std::mutex> guard(Lock);
+            if (Tail == Head)
+                return false;
+            job = Jobs[Head++ % queueCapacity];
+            return true;
+        }
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread>                workers;
+    std::atomic<bool>                       running{ false };
+    std::atomic<int>                        queuedJobs{ 0 };
+    std::mutex                              sleepLock;
+    std::condition_variable                 wakeUp;
+    // 0 is the thread that called Init; threads the pool does not know share its deque
+    thread_local unsigned int               threadIndex = 0;
+
+    void execute(const Job& job)
+    {
+        job.Function(job.Data, job.Begin, job.End);
+        job.Counter->Pending.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void JobSystem::Init(unsigned int workerCount)
+{
+    if (running.load())
+        return;
+    if (workerCount == 0)
+    {
+        const unsigned int hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 0;
+    }
+    for (unsigned int i = 0; i <= workerCount; ++i)
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    running.store(true);
+    for (unsigned int i = 1; i <= workerCount; ++i)
+        workers.emplace_back(&JobSystem::workerLoop, i);
+}
+
+void JobSystem::Shutdown()
+{
+    if (!running.exchange(false))
+        return;
+    wakeUp.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+    workers.clear();
+    queues.clear();
+}
+
+unsigned int JobSystem::ThreadCount()
+{
+    return static_cast<unsigned int>(workers.size()) + 1;
+}
+
+void JobSystem::Submit(const Job& job)
+{
+    job.Counter->Pending.fetch_add(1, std::memory_order_relaxed);
+    if (queues.empty() || !queues[threadIndex]->Push(job))
+    {
+        // no pool or a full deque: run it right here rather than block
+        execute(job);
+        return;
+    }
+    queuedJobs.fetch_add(1, std::memory_order_release);
+    wakeUp.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    while (counter.Pending.load(std::memory_order_acquire) > 0)
+    {
+        if (!runOne())
+            std::this_thread::yield();
+    }
+}
+
+bool JobSystem::runOne()
+{
+    if (queues.empty())
+        return false;
+    Job job;
+    bool found = queues[threadIndex]->Pop(job);
+    for (size_t i = 1; !found && i < queues.size(); ++i)
+        found = queues[(threadIndex + i) % queues.size()]->Steal(job);
+    if (!found)
+        return false;
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    execute(job);
+    return true;
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+    threadIndex = index;
+    int idleSpins = 0;
+    while (running.load(std::memory_order_relaxed))
+    {
+        if (runOne())
+        {
+            idleSpins = 0;
+            continue;
+        }
+        if (++idleSpins < 64)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        // nothing to steal for a while, sleep until a submit (the timeout covers a missed wake-up)
+        std::unique_lock<std::mutex> lock(sleepLock);
+        wakeUp.wait_for(lock, std::chrono::milliseconds(1), [] {
+            return queuedJobs.load() > 0 || !running.load();
+        });
+        idleSpins = 0;
+    }
+}
+
+TaskGraph::TaskID TaskGraph::Add(std::function<void()> task, std::initializer_list<TaskID> dependencies)
+{
+    const TaskID id = static_cast<TaskID>(nodes.size());
+    nodes.push_back(Node());
+    nodes.back().Task = std::move(task);
+    for (const TaskID dependency : dependencies)
+    {
+        nodes[dependency].Successors.push_back(id);
+        nodes.back().DependencyCount++;
+    }
+    return id;
+}
+
+void TaskGraph::Run()
+{
+    if (remainingSize != nodes.size())
+    {
+        remaining.reset(new std::atomic<int>[nodes.size()]);
+        remainingSize = nodes.size();
+    }
+    for (size_t i = 0; i < nodes.size(); ++i)
+        remaining[i].store(nodes[i].DependencyCount, std::memory_order_relaxed);
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (nodes[i].DependencyCount == 0)
+            JobSystem::Submit({ &TaskGraph::runNode, this, i, i + 1, &counter });
+    }
+    JobSystem::Wait(counter);
+}
+
+void TaskGraph::Clear()
+{
+    nodes.clear();
+}
+
+void TaskGraph::runNode(void* data, size_t begin, size_t)
+{
+    TaskGraph* graph = static_cast<TaskGraph*>(data);
+    const Node& node = graph->nodes[begin];
+    node.Task();
+    for (const TaskID successor : node.Successors)
+    {
+        // the last finished dependency releases the successor
+        if (graph->remaining[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            JobSystem::Submit({ &TaskGraph::runNode, graph, successor, successor + 1, &graph->counter });
+    }
+}
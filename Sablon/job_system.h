@@ -0,0 +1,100 @@
+#pragma once
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+typedef void (*JobFunction)(void* data, size_t begin, size_t end);
+
+// counts the unfinished jobs of one batch; JobSystem::Wait blocks until it drops to zero
+struct JobCounter {
+    std::atomic<int> Pending{ 0 };
+};
+
+struct Job {
+    JobFunction Function;
+    void*       Data;
+    size_t      Begin, End;
+    JobCounter* Counter;
+};
+
+// Work-stealing thread pool. Every thread (the workers and the thread that called Init)
+// owns a deque: it pushes and pops its own jobs at the back, idle threads steal from the front.
+// Jobs are plain function pointers, so submitting does not allocate.
+class JobSystem
+{
+public:
+    // workerCount 0 picks one worker per remaining hardware thread
+    static void         Init(unsigned int workerCount = 0);
+    static void         Shutdown();
+    static unsigned int ThreadCount();
+    static void         Submit(const Job& job);
+    // runs other jobs while waiting, so it is safe to call from inside a job
+    static void         Wait(JobCounter& counter);
+    // calls body(begin, end) over [0, count) in chunks of at least grain elements
+    template <typename Body>
+    static void         ParallelFor(size_t count, size_t grain, const Body& body);
+private:
+    JobSystem() { }
+    static bool         runOne();
+    static void         workerLoop(unsigned int index);
+};
+
+// Dependency graph of tasks built once and run any number of times.
+// Tasks without unfinished dependencies run in parallel on the job system.
+class TaskGraph
+{
+public:
+    typedef unsigned int TaskID;
+    TaskID Add(std::function<void()> task, std::initializer_list<TaskID> dependencies = {});
+    void   Run();
+    void   Clear();
+private:
+    struct Node {
+        std::function<void()> Task;
+        std::vector<TaskID>   Successors;
+        int                   DependencyCount = 0;
+    };
+    std::vector<Node>                     nodes;
+    std::unique_ptr<std::atomic<int>[]>   remaining;
+    size_t                                remainingSize = 0;
+    JobCounter                            counter;
+    static void runNode(void* data, size_t begin, size_t end);
+};
+
+template <typename Body>
+void JobSystem::ParallelFor(size_t count, size_t grain, const Body& body)
+{
+    if (count == 0)
+        return;
+    const size_t threads = ThreadCount();
+    // a few chunks per thread leaves room for stealing without flooding the deques
+    size_t chunk = (count + threads * 4 - 1) / (threads * 4);
+    if (chunk < grain)
+        chunk = grain;
+    if (threads == 1 || chunk >= count)
+    {
+        body(static_cast<size_t>(0), count);
+        return;
+    }
+    JobCounter counter;
+    JobFunction invoke = [](void* data, size_t begin, size_t end) {
+        (*static_cast<const Body*>(data))(begin, end);
+    };
+    size_t begin = chunk;
+    for (; begin < count; begin += chunk)
+    {
+        const size_t end = begin + chunk < count ? begin + chunk : count;
+        Submit({ invoke, const_cast<Body*>(&body), begin, end, &counter });
+    }
+    // the calling thread takes the first chunk itself
+    body(static_cast<size_t>(0), chunk);
+    Wait(counter);
+}
+
+#endif
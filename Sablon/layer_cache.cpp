@@ -0,0 +1,120 @@
+#include "layer_cache.h"
+
+#include "memory_tracker.h"
+
+namespace
+{
+    // FNV-1a over the fields, not the struct bytes, since the padding is never initialized
+    constexpr unsigned long long fnvOffset = 14695981039346656037ull;
+    constexpr unsigned long long fnvPrime = 1099511628211ull;
+
+    inline void hashBytes(unsigned long long& hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+            hash = (hash ^ bytes[i]) * fnvPrime;
+    }
+
+    unsigned long long hashSprites(const SpriteCommand* sprites, size_t count)
+    {
+        unsigned long long hash = fnvOffset;
+        hashBytes(hash, &count, sizeof(count));
+        for (size_t i = 0; i < count; ++i)
+        {
+            const SpriteCommand& sprite = sprites[i];
+            const unsigned char flip = sprite.IsFlippedHorizontally ? 1 : 0;
+            hashBytes(hash, &sprite.TextureID, sizeof(sprite.TextureID));
+            hashBytes(hash, &sprite.Position, sizeof(sprite.Position));
+            hashBytes(hash, &sprite.Size, sizeof(sprite.Size));
+            hashBytes(hash, &sprite.Rotation, sizeof(sprite.Rotation));
+            hashBytes(hash, &sprite.Color, sizeof(sprite.Color));
+            hashBytes(hash, &sprite.Alpha, sizeof(sprite.Alpha));
+            hashBytes(hash, &flip, sizeof(flip));
+            hashBytes(hash, &sprite.Threshold, sizeof(sprite.Threshold));
+            hashBytes(hash, &sprite.HighlightColor, sizeof(sprite.HighlightColor));
+        }
+        return hash;
+    }
+}
+
+LayerCache::LayerCache(unsigned int layerCount)
+    : layers(layerCount)
+{
+    for (auto& layer : this->layers)
+    {
+        glGenFramebuffers(1, &layer.Framebuffer);
+        glGenTextures(1, &layer.Texture);
+        layer.Width = 0;
+        layer.Height = 0;
+        layer.Hash = 0;
+        layer.Valid = false;
+    }
+}
+
+LayerCache::~LayerCache()
+{
+    for (const auto& layer : this->layers)
+    {
+        glDeleteFramebuffers(1, &layer.Framebuffer);
+        glDeleteTextures(1, &layer.Texture);
+        MemoryTracker::UntrackTexture(layer.Texture);
+    }
+}
+
+bool LayerCache::NeedsUpdate(unsigned int layer, const SpriteCommand* sprites, size_t count, int width, int height, const glm::mat4& view)
+{
+    Layer& cached = this->layers[layer];
+    unsigned long long hash = hashSprites(sprites, count);
+    hashBytes(hash, &view, sizeof(view));
+    if (cached.Width != width || cached.Height != height)
+    {
+        this->resize(cached, width, height);
+        cached.Valid = false;
+    }
+    if (cached.Valid && cached.Hash == hash)
+        return false;
+    cached.Hash = hash;
+    cached.Valid = true;
+    return true;
+}
+
+void LayerCache::BeginUpdate(unsigned int layer)
+{
+    const Layer& cached = this->layers[layer];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &this->previousFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, cached.Framebuffer);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    // color blends as usual, alpha accumulates coverage, which leaves the layer premultiplied
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void LayerCache::EndUpdate()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, this->previousFramebuffer);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+unsigned int LayerCache::Texture(unsigned int layer) const
+{
+    return this->layers[layer].Texture;
+}
+
+void LayerCache::resize(Layer& layer, int width, int height)
+{
+    layer.Width = width;
+    layer.Height = height;
+    glBindTexture(GL_TEXTURE_2D, layer.Texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    GLint bound = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound);
+    glBindFramebuffer(GL_FRAMEBUFFER, layer.Framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer.Texture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, bound);
+    MemoryTracker::TrackTexture(layer.Texture, width, height, GL_RGBA, MEMORY_RENDER_TARGETS);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "render_queue.h"
+
+// Keeps layers of rarely changing sprites drawn in offscreen framebuffers. A layer is only
+// redrawn when its sprites hash differently from last time, the camera moved or the viewport
+// changed size;
+// otherwise it is put on screen as a single textured quad. Layers hold premultiplied color,
+// so they are composited with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA).
+class LayerCache
+{
+public:
+    explicit LayerCache(unsigned int layerCount);
+    ~LayerCache();
+    // true when the layer has to be redrawn from sprites at a width x height viewport seen through view
+    bool         NeedsUpdate(unsigned int layer, const SpriteCommand* sprites, size_t count, int width, int height, const glm::mat4& view);
+    // redirects drawing into the layer, cleared; EndUpdate() returns to the framebuffer drawn to before
+    void         BeginUpdate(unsigned int layer);
+    void         EndUpdate();
+    unsigned int Texture(unsigned int layer) const;
+private:
+    struct Layer {
+        unsigned int       Framebuffer;
+        unsigned int       Texture;
+        int                Width, Height;
+        unsigned long long Hash;
+        bool               Valid;
+    };
+    std::vector<Layer> layers;
+    GLint              previousFramebuffer = 0;
+    void resize(Layer& layer, int width, int height);
+};
+
+#endif
@@ -0,0 +1,287 @@
+#include "memory_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include <GL/glew.h>
+
+namespace
+{
+    struct TagCounters {
+        std::atomic<size_t>             Bytes{ 0 };
+        std::atomic<size_t>             Peak{ 0 };
+        std::atomic<unsigned long long> Count{ 0 };
+    };
+
+    struct GpuAllocation {
+        size_t    Bytes;
+        MemoryTag Tag;
+    };
+
+    enum GpuObject { GPU_TEXTURE, GPU_BUFFER };
+
+    std::atomic<unsigned long long> allocations{ 0 };
+    unsigned long long              frameStart = 0;
+    TagCounters                     counters[MEMORY_TAG_COUNT];
+    thread_local MemoryTag          currentTag = MEMORY_UNTAGGED;
+
+    std::mutex                                                gpuLock;
+    std::map<std::pair<GpuObject, unsigned int>, GpuAllocation> gpuAllocations;
+
+    void trackGpu(GpuObject kind, unsigned int id, size_t bytes, MemoryTag tag)
+    {
+        std::lock_guard<std::mutex> guard(gpuLock);
+        gpuAllocations[std::make_pair(kind, id)] = { bytes, tag };
+    }
+
+    void untrackGpu(GpuObject kind, unsigned int id)
+    {
+        std::lock_guard<std::mutex> guard(gpuLock);
+        gpuAllocations.erase(std::make_pair(kind, id));
+    }
+
+#ifdef MEMORY_TRACKING
+    // every block carries its size and tag in front, so frees are charged correctly from any thread
+    struct AllocationHeader {
+        size_t    Size;
+        MemoryTag Tag;
+    };
+    constexpr size_t headerSize = 16;
+    static_assert(sizeof(AllocationHeader) <= headerSize, "allocation header does not fit");
+
+    void* trackedAllocate(size_t size)
+    {
+        char* block = static_cast<char*>(std::malloc(size + headerSize));
+        if (!block)
+            return nullptr;
+        const MemoryTag tag = currentTag;
+        AllocationHeader* header = reinterpret_cast<AllocationHeader*>(block);
+        header->Size = size;
+        header->Tag = tag;
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        TagCounters& tagCounters = counters[tag];
+        tagCounters.Count.fetch_add(1, std::memory_order_relaxed);
+        const size_t bytes = tagCounters.Bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = tagCounters.Peak.load(std::memory_order_relaxed);
+        while (bytes > peak && !tagCounters.Peak.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) { }
+        return block + headerSize;
+    }
+
+    void trackedFree(void* memory)
+    {
+        if (!memory)
+            return;
+        char* block = static_cast<char*>(memory) - headerSize;
+        const AllocationHeader* header = reinterpret_cast<AllocationHeader*>(block);
+        counters[header->Tag].Bytes.fetch_sub(header->Size, std::memory_order_relaxed);
+        std::free(block);
+    }
+#endif
+}
+
+#ifdef MEMORY_TRACKING
+void* operator new(size_t size)
+{
+    void* memory = trackedAllocate(size);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    trackedFree(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    trackedFree(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    trackedFree(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    trackedFree(memory);
+}
+#endif
+
+MemoryScope::MemoryScope(MemoryTag tag)
+    : previous(currentTag)
+{
+    currentTag = tag;
+}
+
+MemoryScope::~MemoryScope()
+{
+    currentTag = previous;
+}
+
+bool MemoryTracker::Enabled()
+{
+#ifdef MEMORY_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+unsigned long long MemoryTracker::Allocations()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+MemoryTag MemoryTracker::CurrentTag()
+{
+    return currentTag;
+}
+
+void MemoryTracker::BeginFrame()
+{
+    frameStart = allocations.load(std::memory_order_relaxed);
+}
+
+unsigned long long MemoryTracker::FrameAllocations()
+{
+    return allocations.load(std::memory_order_relaxed) - frameStart;
+}
+
+size_t MemoryTracker::CurrentBytes(MemoryTag tag)
+{
+    return counters[tag].Bytes.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::PeakBytes(MemoryTag tag)
+{
+    return counters[tag].Peak.load(std::memory_order_relaxed);
+}
+
+unsigned long long MemoryTracker::AllocationCount(MemoryTag tag)
+{
+    return counters[tag].Count.load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::TrackTexture(unsigned int id, unsigned int width, unsigned int height, unsigned int internalFormat, MemoryTag tag)
+{
+    trackGpu(GPU_TEXTURE, id, TextureBytes(width, height, internalFormat), tag);
+}
+
+void MemoryTracker::TrackBuffer(unsigned int id, size_t bytes, MemoryTag tag)
+{
+    trackGpu(GPU_BUFFER, id, bytes, tag);
+}
+
+void MemoryTracker::UntrackTexture(unsigned int id)
+{
+    untrackGpu(GPU_TEXTURE, id);
+}
+
+void MemoryTracker::UntrackBuffer(unsigned int id)
+{
+    untrackGpu(GPU_BUFFER, id);
+}
+
+size_t MemoryTracker::GpuBytes(MemoryTag tag)
+{
+    std::lock_guard<std::mutex> guard(gpuLock);
+    size_t bytes = 0;
+    for (const auto& allocation : gpuAllocations)
+    {
+        if (allocation.second.Tag == tag)
+            bytes += allocation.second.Bytes;
+    }
+    return bytes;
+}
+
+size_t MemoryTracker::TextureBytes(unsigned int width, unsigned int height, unsigned int internalFormat)
+{
+    // drivers pad RGB to four bytes per texel
+    size_t bytesPerTexel = 4;
+    switch (internalFormat)
+    {
+    case GL_RED:
+    case GL_R8:
+        bytesPerTexel = 1;
+        break;
+    case GL_RG:
+    case GL_RG8:
+        bytesPerTexel = 2;
+        break;
+    case GL_RGBA16F:
+        bytesPerTexel = 8;
+        break;
+    case GL_RGBA32F:
+        bytesPerTexel = 16;
+        break;
+    default:
+        break;
+    }
+    return static_cast<size_t>(width) * height * bytesPerTexel;
+}
+
+const char* MemoryTracker::TagName(MemoryTag tag)
+{
+    switch (tag)
+    {
+    case MEMORY_RESOURCES:   return "resources";
+    case MEMORY_TEXT:        return "text";
+    case MEMORY_SPRITES:     return "sprites";
+    case MEMORY_SCENE:       return "scene";
+    case MEMORY_FRAME_ARENA: return "frame arena";
+    case MEMORY_RENDER_TARGETS: return "targets";
+    case MEMORY_PARTICLES:   return "particles";
+    default:                 return "untagged";
+    }
+}
+
+void MemoryTracker::Report(std::ostream& out)
+{
+    const double kilobyte = 1024.0;
+    const std::ios::fmtflags flags = out.flags();
+    out << "| MEMORY REPORT" << (Enabled() ? "" : " (CPU tracking is compiled out in this build)") << "\n"
+        << "  " << std::left << std::setw(12) << "subsystem" << std::right
+        << std::setw(14) << "CPU KiB" << std::setw(14) << "CPU peak KiB"
+        << std::setw(12) << "allocs" << std::setw(14) << "GPU KiB" << "\n";
+    size_t cpuTotal = 0, gpuTotal = 0;
+    out << std::fixed << std::setprecision(1);
+    for (int i = 0; i < MEMORY_TAG_COUNT; ++i)
+    {
+        const MemoryTag tag = static_cast<MemoryTag>(i);
+        const size_t gpu = GpuBytes(tag);
+        cpuTotal += CurrentBytes(tag);
+        gpuTotal += gpu;
+        out << "  " << std::left << std::setw(12) << TagName(tag) << std::right
+            << std::setw(14) << CurrentBytes(tag) / kilobyte
+            << std::setw(14) << PeakBytes(tag) / kilobyte
+            << std::setw(12) << AllocationCount(tag)
+            << std::setw(14) << gpu / kilobyte << "\n";
+    }
+    out << "  " << std::left << std::setw(12) << "total" << std::right
+        << std::setw(14) << cpuTotal / kilobyte << std::setw(26) << ""
+        << std::setw(14) << gpuTotal / kilobyte << "\n"
+        << "  allocations last frame: " << FrameAllocations() << std::endl;
+    out.flags(flags);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <cstddef>
+#include <ostream>
+
+// debug builds replace the global operator new/delete to count heap allocations
+#if defined(_DEBUG) || !defined(NDEBUG)
+#define MEMORY_TRACKING 1
+#endif
+
+enum MemoryTag {
+    MEMORY_UNTAGGED,
+    MEMORY_RESOURCES,
+    MEMORY_TEXT,
+    MEMORY_SPRITES,
+    MEMORY_SCENE,
+    MEMORY_FRAME_ARENA,
+    MEMORY_RENDER_TARGETS,
+    MEMORY_PARTICLES,
+    MEMORY_TAG_COUNT
+};
+
+// heap allocations made on this thread while the scope is alive are charged to tag
+class MemoryScope
+{
+public:
+    explicit MemoryScope(MemoryTag tag);
+    ~MemoryScope();
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+private:
+    MemoryTag previous;
+};
+
+class MemoryTracker
+{
+public:
+    // false when the allocation hook is compiled out, all CPU counters then stay at zero
+    static bool               Enabled();
+    // operator new calls since startup, from every thread
+    static unsigned long long Allocations();
+    // tag of the innermost MemoryScope on this thread
+    static MemoryTag          CurrentTag();
+    static void               BeginFrame();
+    static unsigned long long FrameAllocations();
+    static size_t             CurrentBytes(MemoryTag tag);
+    static size_t             PeakBytes(MemoryTag tag);
+    static unsigned long long AllocationCount(MemoryTag tag);
+    // GPU memory is estimated from what we ask the driver for; id is the GL object name
+    static void               TrackTexture(unsigned int id, unsigned int width, unsigned int height, unsigned int internalFormat, MemoryTag tag);
+    static void               TrackBuffer(unsigned int id, size_t bytes, MemoryTag tag);
+    static void               UntrackTexture(unsigned int id);
+    static void               UntrackBuffer(unsigned int id);
+    static size_t             GpuBytes(MemoryTag tag);
+    static size_t             TextureBytes(unsigned int width, unsigned int height, unsigned int internalFormat);
+    static void               Report(std::ostream& out);
+    static const char*        TagName(MemoryTag tag);
+private:
+    MemoryTracker() { }
+};
+
+#endif
@@ -0,0 +1,10 @@
+#version 330 core
+in vec4 ParticleColor;
+out vec4 color;
+
+void main()
+{
+    // soft round dot
+    float distance = length(gl_PointCoord - vec2(0.5)) * 2.0;
+    color = vec4(ParticleColor.rgb, ParticleColor.a * (1.0 - smoothstep(0.5, 1.0, distance)));
+}
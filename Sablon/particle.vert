@@ -0,0 +1,38 @@
+#version 330 core
+layout (location = 0) in vec4 motion; // <vec2 position, vec2 velocity>
+layout (location = 1) in vec4 life;   // <float age, float lifetime, float emitter, unused>
+
+out vec4 ParticleColor;
+
+const int maxEmitters = 8;
+// per-frame constants shared by every program, see FrameConstants in render_queue.h
+layout (std140) uniform FrameConstants
+{
+    mat4  projection;
+    mat4  view;
+    vec2  viewportSize;     // pixels
+    float time;             // seconds of game time
+    float sunAngle;         // degrees
+};
+uniform vec4  emitterColor[maxEmitters];
+uniform vec2  emitterSize[maxEmitters];     // world units at birth and at death
+
+void main()
+{
+    int emitter = int(life.z);
+    float t = life.x / life.y;
+    if (life.x <= 0.0 || t >= 1.0)
+    {
+        // not born yet: outside the clip volume, so nothing is rasterized
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        gl_PointSize = 1.0;
+        ParticleColor = vec4(0.0);
+        return;
+    }
+    float fade = smoothstep(0.0, 0.1, t) * (1.0 - smoothstep(0.6, 1.0, t));
+    ParticleColor = vec4(emitterColor[emitter].rgb, emitterColor[emitter].a * fade);
+    // sizes are in world units; the projection's y scale says how many pixels one is
+    float pixelsPerUnit = 0.5 * viewportSize.y * abs(projection[1][1] * view[1][1]);
+    gl_PointSize = mix(emitterSize[emitter].x, emitterSize[emitter].y, t) * pixelsPerUnit;
+    gl_Position = projection * view * vec4(motion.xy, 0.0, 1.0);
+}
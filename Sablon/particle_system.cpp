@@ -0,0 +1,169 @@
+#include "particle_system.h"
+
+#include "game_object.h"
+#include "memory_tracker.h"
+
+namespace
+{
+    // one particle in the GPU buffers, matching the shaders' motion and life attributes
+    struct Particle {
+        glm::vec4 Motion;   // position, velocity
+        glm::vec4 Life;     // age, lifetime, emitter, unused
+    };
+
+    constexpr unsigned int computeGroupSize = 256;
+}
+
+ParticleSystem::ParticleSystem(Shader& render, Shader& update, bool compute, unsigned int capacity)
+    : render(render), update(update), compute(compute), capacity(capacity), current(0), frame(0), used(0), reset(false)
+{
+    const unsigned int bufferCount = compute ? 1 : 2;
+    glGenVertexArrays(bufferCount, this->VAO);
+    glGenBuffers(bufferCount, this->VBO);
+    for (unsigned int i = 0; i < bufferCount; ++i)
+    {
+        glBindVertexArray(this->VAO[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO[i]);
+        // contents are written by the first reset on the GPU
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Particle), NULL, GL_DYNAMIC_COPY);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)sizeof(glm::vec4));
+        MemoryTracker::TrackBuffer(this->VBO[i], capacity * sizeof(Particle), MEMORY_PARTICLES);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    const unsigned int bufferCount = this->compute ? 1 : 2;
+    glDeleteVertexArrays(bufferCount, this->VAO);
+    glDeleteBuffers(bufferCount, this->VBO);
+    for (unsigned int i = 0; i < bufferCount; ++i)
+        MemoryTracker::UntrackBuffer(this->VBO[i]);
+}
+
+bool ParticleSystem::ComputeAvailable()
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    return major > 4 || (major == 4 && minor >= 3);
+}
+
+bool ParticleSystem::AddEmitter(const GameObject* object, const ParticleEmitterSettings& settings)
+{
+    if (this->emitters.size() == maxParticleEmitters || settings.Count > this->capacity - this->used)
+        return false;
+    this->emitters.push_back({ object, settings, static_cast<int>(this->used) });
+    this->used += settings.Count;
+    this->reset = true;
+    return true;
+}
+
+void ParticleSystem::Begin(CommandBuffer& commands)
+{
+    this->recording = &commands;
+}
+
+void ParticleSystem::End()
+{
+    this->recording = nullptr;
+}
+
+void ParticleSystem::Draw(float dt)
+{
+    ParticleCommand command;
+    command.EmitterCount = static_cast<unsigned int>(this->emitters.size());
+    command.ParticleCount = this->used;
+    command.Dt = dt;
+    command.Reset = this->reset;
+    this->reset = false;
+    for (size_t i = 0; i < this->emitters.size(); ++i)
+    {
+        const Emitter& emitter = this->emitters[i];
+        const ParticleEmitterSettings& settings = emitter.Settings;
+        const glm::vec2 position = emitter.Object->Position, size = emitter.Object->Size;
+        command.Emitters[i] = {
+            glm::vec4(position + glm::vec2(settings.Area.x, settings.Area.y) * size,
+                      position + glm::vec2(settings.Area.z, settings.Area.w) * size),
+            glm::vec4(settings.Velocity, settings.Spread),
+            settings.Lifetime, settings.Size, settings.Color, emitter.First };
+    }
+    if (this->recording)
+        this->recording->PushParticles(command);
+    else
+        this->Execute(command);
+}
+
+void ParticleSystem::Execute(const ParticleCommand& command)
+{
+    if (command.ParticleCount == 0)
+        return;
+    this->simulate(command);
+
+    glm::vec4 colors[maxParticleEmitters];
+    glm::vec2 sizes[maxParticleEmitters];
+    for (unsigned int i = 0; i < command.EmitterCount; ++i)
+    {
+        colors[i] = command.Emitters[i].Color;
+        sizes[i] = command.Emitters[i].Size;
+    }
+    this->render.Use();
+    glUniform4fv(glGetUniformLocation(this->render.ID, "emitterColor"), command.EmitterCount, &colors[0].x);
+    glUniform2fv(glGetUniformLocation(this->render.ID, "emitterSize"), command.EmitterCount, &sizes[0].x);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glBindVertexArray(this->VAO[this->current]);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(command.ParticleCount));
+    glBindVertexArray(0);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+}
+
+void ParticleSystem::simulate(const ParticleCommand& command)
+{
+    int firsts[maxParticleEmitters];
+    glm::vec4 areas[maxParticleEmitters], velocities[maxParticleEmitters];
+    glm::vec2 lifetimes[maxParticleEmitters];
+    for (unsigned int i = 0; i < command.EmitterCount; ++i)
+    {
+        firsts[i] = command.Emitters[i].First;
+        areas[i] = command.Emitters[i].Area;
+        velocities[i] = command.Emitters[i].Velocity;
+        lifetimes[i] = command.Emitters[i].Lifetime;
+    }
+    const GLuint program = this->update.ID;
+    this->update.Use();
+    this->update.SetInteger("emitterCount", static_cast<int>(command.EmitterCount));
+    glUniform1iv(glGetUniformLocation(program, "emitterFirst"), command.EmitterCount, firsts);
+    glUniform4fv(glGetUniformLocation(program, "emitterArea"), command.EmitterCount, &areas[0].x);
+    glUniform4fv(glGetUniformLocation(program, "emitterVelocity"), command.EmitterCount, &velocities[0].x);
+    glUniform2fv(glGetUniformLocation(program, "emitterLifetime"), command.EmitterCount, &lifetimes[0].x);
+    this->update.SetFloat("dt", command.Dt);
+    glUniform1ui(glGetUniformLocation(program, "frame"), this->frame++);
+    this->update.SetInteger("reset", command.Reset ? 1 : 0);
+
+    if (this->compute)
+    {
+        this->update.SetInteger("particleCount", static_cast<int>(command.ParticleCount));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, this->VBO[0]);
+        glDispatchCompute((command.ParticleCount + computeGroupSize - 1) / computeGroupSize, 1, 1);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+        // the draw below reads the buffer as vertex attributes
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        return;
+    }
+    // read this frame's buffer as points, capture the next state into the other one
+    const unsigned int next = 1 - this->current;
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(this->VAO[this->current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, this->VBO[next]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(command.ParticleCount));
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    this->current = next;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "render_queue.h"
+
+class GameObject;
+
+// how an emitter spawns particles relative to the object it is attached to
+struct ParticleEmitterSettings {
+    glm::vec4 Area;         // spawn rectangle as fractions of the object's bounds, min.xy and max.xy
+    glm::vec2 Velocity;     // world units per second
+    glm::vec2 Spread;       // random offset of up to +-Spread added to Velocity
+    glm::vec2 Lifetime;     // min and max seconds
+    glm::vec2 Size;         // world units at birth and at death
+    glm::vec4 Color;
+    unsigned int Count;
+};
+
+// Particles that live entirely on the GPU. The simulation runs in a compute shader when the
+// context has GL 4.3, otherwise in a vertex shader whose outputs are captured with transform
+// feedback into a second buffer (GL 3.3). Either way the CPU only sends the emitters, a few
+// uniforms per frame, so the particle count does not show up in CPU time.
+class ParticleSystem
+{
+public:
+    // update is the compute program when compute is set, else the transform feedback program
+    ParticleSystem(Shader& render, Shader& update, bool compute, unsigned int capacity);
+    ~ParticleSystem();
+    // whether the current context can run the compute path
+    static bool ComputeAvailable();
+    // spawns settings.Count particles around object from the next frame on; false when the
+    // emitter slots or the capacity are used up
+    bool AddEmitter(const GameObject* object, const ParticleEmitterSettings& settings);
+    // while recording, Draw appends to the command buffer instead of issuing GL calls
+    void Begin(CommandBuffer& commands);
+    void End();
+    // advances the simulation by dt and draws it
+    void Draw(float dt);
+    void Execute(const ParticleCommand& command);
+private:
+    struct Emitter {
+        const GameObject*       Object;
+        ParticleEmitterSettings Settings;
+        int                     First;
+    };
+    Shader               render;
+    Shader               update;
+    bool                 compute;
+    unsigned int         capacity;
+    unsigned int         VAO[2], VBO[2];   // transform feedback ping-pongs, compute uses the first
+    unsigned int         current;
+    unsigned int         frame;
+    std::vector<Emitter> emitters;
+    unsigned int         used;
+    bool                 reset;
+    CommandBuffer*       recording = nullptr;
+    void simulate(const ParticleCommand& command);
+};
+
+#endif
@@ -0,0 +1,60 @@
+#version 330 core
+layout (location = 0) in vec4 motion; // <vec2 position, vec2 velocity>
+layout (location = 1) in vec4 life;   // <float age, float lifetime, float emitter, unused>
+
+// captured by transform feedback into the other particle buffer
+out vec4 outMotion;
+out vec4 outLife;
+
+const int maxEmitters = 8;
+uniform int   emitterCount;
+uniform int   emitterFirst[maxEmitters];        // first particle of each emitter
+uniform vec4  emitterArea[maxEmitters];         // spawn rectangle, min.xy and max.xy
+uniform vec4  emitterVelocity[maxEmitters];     // base velocity.xy, spread.xy
+uniform vec2  emitterLifetime[maxEmitters];     // min and max seconds
+uniform float dt;
+uniform uint  frame;
+uniform bool  reset;
+
+uint pcg(uint v)
+{
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float random(inout uint seed)
+{
+    seed = pcg(seed);
+    return float(seed) * (1.0 / 4294967295.0);
+}
+
+void main()
+{
+    int emitter = 0;
+    for (int i = 1; i < emitterCount; ++i)
+        if (gl_VertexID >= emitterFirst[i])
+            emitter = i;
+    uint seed = pcg(uint(gl_VertexID) ^ pcg(frame));
+
+    vec2 position = motion.xy;
+    vec2 velocity = motion.zw;
+    float age = life.x + dt;
+    float lifetime = life.y;
+    if (reset || age >= lifetime)
+    {
+        vec4 area = emitterArea[emitter];
+        vec4 launch = emitterVelocity[emitter];
+        position = mix(area.xy, area.zw, vec2(random(seed), random(seed)));
+        velocity = launch.xy + launch.zw * (vec2(random(seed), random(seed)) * 2.0 - 1.0);
+        lifetime = mix(emitterLifetime[emitter].x, emitterLifetime[emitter].y, random(seed));
+        // a reset staggers the first births over one lifetime so there is no initial burst
+        age = reset ? -random(seed) * lifetime : 0.0;
+    }
+    else if (age > 0.0)
+    {
+        position += velocity * dt;
+    }
+    outMotion = vec4(position, velocity);
+    outLife = vec4(age, lifetime, float(emitter), 0.0);
+}
@@ -1,18 +1,36 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#include "game.h"
+#include "Game.h"
 #include "resource_manager.h"
+#include "render_queue.h"
+#include "render_thread.h"
+#include "job_system.h"
+#include "memory_tracker.h"
+#include "input_log.h"
+#include "shader_cache.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <thread>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void window_refresh_callback(GLFWwindow* window);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
+void apply_key(int key, int action);
+void apply_click(double x, double y);
 constexpr float targetFPS = 60.0f;
 constexpr float targetFrameTime = 1.0f / targetFPS;
+// an idle window still wakes this often, for chunks that finished streaming in meanwhile
+constexpr double idleTimeout = 0.25;
+// with time paused the fish, the sand and the stars are drawn this often rather than every frame
+constexpr float ambientFrameTime = 1.0f / 10.0f;
 
 Game Egipt;
+RenderThread* GLThread = nullptr;
+InputLog Input;
 
 void mouse_callback(GLFWwindow* window, int button, int action, int mods);
 
@@ -34,6 +52,7 @@ int main(int argc, char* argv[])
     GLFWmonitor* monitor = glfwGetPrimaryMonitor();
     const GLFWvidmode* mode = glfwGetVideoMode(monitor);
     Egipt = Game(mode->width, mode->height);
+    Egipt.TargetFrameTime = targetFrameTime;
     GLFWwindow* window = glfwCreateWindow(mode->width, mode->height, "Egipt 2D", NULL, NULL); // Napravi novi prozor
     // glfwCreateWindow( sirina, visina, naslov, monitor na koji ovaj prozor ide preko citavog ekrana (u tom slucaju umjesto NULL ide glfwGetPrimaryMonitor() ), i prozori sa kojima ce dijeliti resurse )
     if (window == NULL) //Ako prozor nije napravljen
@@ -56,53 +75,201 @@ int main(int argc, char* argv[])
     glfwSetMouseButtonCallback(window, mouse_callback);
 
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
 
     // OpenGL configuration
     // --------------------
     glViewport(0, 0, mode->width, mode->height);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // let the driver compile shaders on as many threads as it likes
+    if (GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
+    // command line options
+    // --------------------
+    bool threadedRendering = false;
+    bool shaderCache = true;
+    bool failOnFrameAllocations = false;
+    unsigned int workerCount = 0;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    Egipt.Seed = static_cast<unsigned long long>(std::time(nullptr));
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--threaded") == 0)
+            threadedRendering = true;
+        else if (std::strcmp(argv[i], "--fail-on-frame-allocations") == 0)
+            failOnFrameAllocations = true;
+        else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+            workerCount = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--stars") == 0 && i + 1 < argc)
+            Egipt.StarCount = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--particles") == 0 && i + 1 < argc)
+            Egipt.ParticleCount = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--chunk-budget") == 0 && i + 1 < argc)
+            Egipt.ChunkBudget = static_cast<size_t>(std::atoi(argv[++i])) << 20;
+        else if (std::strcmp(argv[i], "--no-compute") == 0)
+            Egipt.ComputeParticles = false;
+        else if (std::strcmp(argv[i], "--dynamic-resolution") == 0)
+            Egipt.DynamicResolution = true;
+        else if (std::strcmp(argv[i], "--resolution-scale") == 0 && i + 2 < argc)
+        {
+            Egipt.DynamicResolution = true;
+            Egipt.MinResolutionScale = static_cast<float>(std::atof(argv[++i]));
+            Egipt.MaxResolutionScale = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            Egipt.Seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            Egipt.TracePath = argv[++i];
+        else if (std::strcmp(argv[i], "--no-shader-cache") == 0)
+            shaderCache = false;
+    }
+    // a replay rebuilds the recorded scene and runs unthrottled
+    if (replayPath)
+    {
+        if (!Input.Replay(replayPath))
+            return 5;
+        Egipt.Seed = Input.Seed;
+        glfwSwapInterval(0);
+    }
+    else if (recordPath && !Input.Record(recordPath, Egipt.Seed))
+        return 5;
+    // clicks and draws depend on which chunks are in, so the recording streams them as the replays will
+    Egipt.DeterministicStreaming = replayPath || recordPath;
+    std::cout << "Seed " << Egipt.Seed << "\n";
 
     // initialize game
     // ---------------
+    JobSystem::Init(workerCount);
+    if (shaderCache)
+        ShaderCache::Init("shader_cache");
     Egipt.Init();
+    if (ShaderCache::Enabled())
+        std::cout << "Shader cache: " << ShaderCache::Hits << " programs loaded, " << ShaderCache::Misses << " compiled\n";
+
+    // optional dedicated GL thread: the loop below records frame N+1 while frame N is drawn
+    // ---------------------------------------------------------------------------------
+    RenderQueue renderQueue;
+    CommandBuffer frameCommands;
+    RenderThread renderThread(window, Egipt, renderQueue);
+    if (threadedRendering)
+    {
+        glfwMakeContextCurrent(NULL);
+        GLThread = &renderThread;
+        renderThread.Start();
+    }
 
     // deltaTime variables
     // -------------------
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
     float start_closing = 0.0f;
+    // steady state is reached once every lazily grown buffer has seen a full frame
+    constexpr unsigned int warmupFrames = 120;
+    unsigned int frameIndex = 0;
+    bool reportedFrameAllocations = false;
+    int exitCode = 0;
+    const double replayStart = glfwGetTime();
 
     while (!glfwWindowShouldClose(window))
     {
 
         // calculate delta time
         // --------------------
+        MemoryTracker::BeginFrame();
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
         glfwPollEvents();
+        if (Input.Replaying())
+        {
+            // the recorded events of this frame, then its delta time
+            InputEvent event;
+            while (Input.Next(frameIndex, event))
+            {
+                if (event.Type == INPUT_KEY)
+                    apply_key(event.Key, event.Action);
+                else if (event.Type == INPUT_CLICK)
+                    apply_click(event.X, event.Y);
+                else
+                    deltaTime = event.X;
+            }
+        }
+        else
+            Input.Write({ 0, INPUT_FRAME, 0, 0, deltaTime, 0.0f });
 
         Egipt.ProcessInput(0);
         // update game state
         // -----------------
         Egipt.Update(deltaTime);
 
-        // render
+        // render, unless the last frame on screen is still right; replays always render so
+        // every run does the same work
         // ------
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        const bool should_close = Egipt.Render();
+        const bool idle = !Egipt.NeedsRedraw() && !Input.Replaying();
+        const bool ambient = Egipt.AmbientOnly() && !Input.Replaying();
+        bool should_close = false;
+        if (threadedRendering && !idle)
+        {
+            CommandBuffer& commands = renderQueue.BeginFrame();
+            should_close = Egipt.Record(commands);
+            renderQueue.EndFrame();
+        }
+        else if (!idle)
+        {
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            // record first so sprites are drawn in batches rather than one call each
+            frameCommands.Clear();
+            should_close = Egipt.Record(frameCommands);
+            Egipt.Execute(frameCommands);
+        }
         if (should_close)
         {
             start_closing = currentFrame;
         }
 
 
-        glfwSwapBuffers(window);
+        if (!threadedRendering && !idle)
+            glfwSwapBuffers(window);
+
+        // debug builds count heap allocations; a steady-state frame should not make any
+        if (++frameIndex > warmupFrames && !reportedFrameAllocations && MemoryTracker::FrameAllocations() > 0)
+        {
+            std::cout << "Frame " << frameIndex << " made " << MemoryTracker::FrameAllocations() << " heap allocations\n";
+            reportedFrameAllocations = true;
+            if (failOnFrameAllocations)
+            {
+                exitCode = 4;
+                glfwSetWindowShouldClose(window, true);
+            }
+        }
+
+        if (Input.Ended())
+        {
+            glfwSetWindowShouldClose(window, true);
+        }
 
         float frameTime = glfwGetTime() - currentFrame;
-        if (frameTime < targetFrameTime)
+        if (idle)
+        {
+            // nothing to draw: sleep until input arrives, and do not count the wait as frame time
+            glfwWaitEventsTimeout(idleTimeout);
+            lastFrame = glfwGetTime();
+        }
+        else if (ambient && frameTime < ambientFrameTime)
+        {
+            // only the ambient animation moved: wait out the lower rate, waking for input, and
+            // count the wait as frame time so the fish and the sand keep their speed
+            glfwWaitEventsTimeout(ambientFrameTime - frameTime);
+        }
+        else if (frameTime < targetFrameTime && !Input.Replaying())
         {
             // Sleep for the remaining time to achieve 60 FPS
             std::this_thread::sleep_for(std::chrono::duration<float>(targetFrameTime - frameTime));
@@ -113,12 +280,27 @@ int main(int argc, char* argv[])
         }
     }
 
+    if (threadedRendering)
+    {
+        renderThread.Stop();
+        GLThread = nullptr;
+        glfwMakeContextCurrent(window);
+    }
+
+    if (Input.Replaying())
+    {
+        std::cout << "Replayed " << frameIndex << " frames in " << glfwGetTime() - replayStart << " s\n";
+    }
+    Input.Close();
+
     // delete all resources as loaded using the resource manager
     // ---------------------------------------------------------
     ResourceManager::Clear();
+    JobSystem::Shutdown();
+    MemoryTracker::Report(std::cout);
 
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
@@ -130,6 +312,20 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     }
 
 
+    // Print per-subsystem memory use on M
+    if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+        MemoryTracker::Report(std::cout);
+    }
+
+    // a replay only sees the recorded input
+    if (Input.Replaying())
+        return;
+    Input.Write({ 0, INPUT_KEY, static_cast<uint8_t>(action), static_cast<uint16_t>(key), 0.0f, 0.0f });
+    apply_key(key, action);
+}
+
+void apply_key(int key, int action)
+{
     // Process specific keys on key release
     if (action == GLFW_RELEASE) {
         switch (key) {
@@ -142,6 +338,8 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         case GLFW_KEY_3:
         case GLFW_KEY_G:
         case GLFW_KEY_O:
+        case GLFW_KEY_C:
+        case GLFW_KEY_HOME:
             Egipt.ProcessInput(key);
             break;
 		default: ;
@@ -160,22 +358,41 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     }
 
     if (key >= 0 && key < 1024) {
-        Egipt.Keys[key] = (action == GLFW_PRESS);
+        // repeats keep a key down, so held keys work past the first repeat
+        Egipt.Keys[key] = (action != GLFW_RELEASE);
     }
 }
 
 void mouse_callback(GLFWwindow* window, int button, int action, int mods)
 {
 
-    if (action == GLFW_PRESS && button == GLFW_MOUSE_BUTTON_LEFT)
+    if (action == GLFW_PRESS && button == GLFW_MOUSE_BUTTON_LEFT && !Input.Replaying())
     {
         double xpos, ypos;
         glfwGetCursorPos(window, &xpos, &ypos);
-        Egipt.ProcessMouseClick(xpos, ypos);
+        // stored as floats, so the live run clicks exactly where the replay will
+        Input.Write({ 0, INPUT_CLICK, 0, 0, static_cast<float>(xpos), static_cast<float>(ypos) });
+        apply_click(static_cast<float>(xpos), static_cast<float>(ypos));
     }
 }
 
+void apply_click(double x, double y)
+{
+    Egipt.ProcessMouseClick(x, y);
+}
+
+void window_refresh_callback(GLFWwindow* window)
+{
+    // the window system lost what was on screen
+    Egipt.Invalidate();
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    Egipt.Resize(width, height);
+    // the context lives on the GL thread in threaded mode
+    if (GLThread)
+        GLThread->Resize(width, height);
+    else
+        glViewport(0, 0, width, height);
 }
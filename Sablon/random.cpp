@@ -0,0 +1,68 @@
+#include "random.h"
+
+constexpr uint64_t multiplier = 6364136223846793005ULL;
+
+Random::Random(uint64_t seed, uint64_t stream)
+    : state(0), increment((stream << 1) | 1)
+{
+    this->Next();
+    this->state += seed;
+    this->Next();
+}
+
+uint32_t Random::Next()
+{
+    const uint64_t old = this->state;
+    this->state = old * multiplier + this->increment;
+    const uint32_t shifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+    const uint32_t rotation = static_cast<uint32_t>(old >> 59);
+    return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+}
+
+float Random::Float()
+{
+    // the top 24 bits fill the float mantissa exactly, so 1.0 is never returned
+    return static_cast<float>(this->Next() >> 8) * (1.0f / 16777216.0f);
+}
+
+float Random::Float(float min, float max)
+{
+    return min + (max - min) * this->Float();
+}
+
+uint32_t Random::Int(uint32_t bound)
+{
+    // multiply and keep the high half instead of a division; the bias is below bound / 2^32
+    return static_cast<uint32_t>((static_cast<uint64_t>(this->Next()) * bound) >> 32);
+}
+
+void Random::Fill(float* values, size_t count, float min, float max)
+{
+    for (size_t i = 0; i < count; ++i)
+        values[i] = this->Float(min, max);
+}
+
+void Random::Fill(uint32_t* values, size_t count, uint32_t bound)
+{
+    for (size_t i = 0; i < count; ++i)
+        values[i] = this->Int(bound);
+}
+
+void Random::Advance(uint64_t delta)
+{
+    // composes the LCG step with itself by squaring, one bit of delta at a time
+    uint64_t stepMultiplier = multiplier, stepIncrement = this->increment;
+    uint64_t totalMultiplier = 1, totalIncrement = 0;
+    while (delta > 0)
+    {
+        if (delta & 1)
+        {
+            totalMultiplier *= stepMultiplier;
+            totalIncrement = totalIncrement * stepMultiplier + stepIncrement;
+        }
+        stepIncrement = (stepMultiplier + 1) * stepIncrement;
+        stepMultiplier *= stepMultiplier;
+        delta >>= 1;
+    }
+    this->state = totalMultiplier * this->state + totalIncrement;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// PCG32 generator: 16 bytes of state (state plus stream increment), no locks, and the same
+// sequence for the same seed on every platform. Each stream is an independent sequence, so every
+// system that needs random numbers takes its own stream of one seed and does not disturb the others.
+class Random
+{
+public:
+    explicit Random(uint64_t seed = 0, uint64_t stream = 0);
+    uint32_t Next();
+    // uniform in [0, 1)
+    float    Float();
+    // uniform in [min, max)
+    float    Float(float min, float max);
+    // uniform in [0, bound), a drop-in for rand() % bound
+    uint32_t Int(uint32_t bound);
+    // batches of the calls above, the same values as calling them count times
+    void     Fill(float* values, size_t count, float min, float max);
+    void     Fill(uint32_t* values, size_t count, uint32_t bound);
+    // skips delta numbers in O(log delta), so chunks of a parallel loop can each start at
+    // their own offset and produce what a single loop would
+    void     Advance(uint64_t delta);
+private:
+    uint64_t state;
+    uint64_t increment;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "render_cull.h"
+
+#include <cmath>
+
+#include "resource_manager.h"
+
+namespace
+{
+    void spriteBounds(const SpriteCommand& sprite, glm::vec2& min, glm::vec2& max)
+    {
+        glm::vec2 half = 0.5f * sprite.Size;
+        if (sprite.Rotation != 0.0f)
+        {
+            const float radians = glm::radians(sprite.Rotation);
+            const float c = std::fabs(std::cos(radians)), s = std::fabs(std::sin(radians));
+            half = glm::vec2(c * half.x + s * half.y, s * half.x + c * half.y);
+        }
+        const glm::vec2 center = sprite.Position + 0.5f * sprite.Size;
+        min = center - half;
+        max = center + half;
+    }
+
+    // rows [top, bottom] of the screen that sprite paints fully opaque across the viewport
+    bool occludedRows(const SpriteCommand& sprite, glm::vec2 viewMin, glm::vec2 viewMax, float& top, float& bottom)
+    {
+        if (sprite.Alpha < 1.0f || sprite.Rotation != 0.0f
+            || sprite.Position.x > viewMin.x || sprite.Position.x + sprite.Size.x < viewMax.x)
+            return false;
+        float opaqueTop = 0.0f, opaqueBottom = 1.0f;
+        if (const AlphaMask* mask = ResourceManager::GetAlphaMask(sprite.TextureID))
+        {
+            opaqueTop = mask->OpaqueTop;
+            opaqueBottom = mask->OpaqueBottom;
+        }
+        if (opaqueTop >= opaqueBottom)
+            return false;
+        top = sprite.Position.y + opaqueTop * sprite.Size.y;
+        bottom = sprite.Position.y + opaqueBottom * sprite.Size.y;
+        return true;
+    }
+}
+
+CullStats CullSprites(CommandBuffer& commands, glm::vec2 viewMin, glm::vec2 viewMax)
+{
+    CullStats stats = { 0, 0, 0, 0, 0 };
+    // back to front so every sprite has already seen whatever is drawn over it; culled
+    // sprites get zero alpha here and are compacted away below
+    float bandTop = 0.0f, bandBottom = -1.0f;
+    for (size_t i = commands.Commands.size(); i-- > 0;)
+    {
+        if (commands.Commands[i].Type != RENDER_SPRITE)
+            continue;
+        SpriteCommand& sprite = commands.Sprites[commands.Commands[i].Index];
+        stats.Submitted++;
+        if (sprite.Alpha <= 0.0f)
+        {
+            stats.Transparent++;
+            continue;
+        }
+        glm::vec2 min, max;
+        spriteBounds(sprite, min, max);
+        if (max.x < viewMin.x || min.x > viewMax.x || max.y < viewMin.y || min.y > viewMax.y)
+        {
+            stats.Offscreen++;
+            sprite.Alpha = 0.0f;
+            continue;
+        }
+        if (std::fmax(min.y, viewMin.y) >= bandTop && std::fmin(max.y, viewMax.y) <= bandBottom)
+        {
+            stats.Occluded++;
+            sprite.Alpha = 0.0f;
+            continue;
+        }
+        stats.Visible++;
+        float top, bottom;
+        if (occludedRows(sprite, viewMin, viewMax, top, bottom))
+        {
+            // one band is enough for a layered 2D scene; merge when they touch, else keep the taller
+            if (top <= bandBottom && bottom >= bandTop)
+            {
+                bandTop = std::fmin(bandTop, top);
+                bandBottom = std::fmax(bandBottom, bottom);
+            }
+            else if (bottom - top > bandBottom - bandTop)
+            {
+                bandTop = top;
+                bandBottom = bottom;
+            }
+        }
+    }
+    if (stats.Visible == stats.Submitted)
+        return stats;
+
+    // sprite indices grow with the command order, so compacting in place keeps every run of
+    // sprite commands pointing at consecutive sprites
+    size_t commandCount = 0, spriteCount = 0;
+    for (size_t i = 0; i < commands.Commands.size(); ++i)
+    {
+        RenderCommand command = commands.Commands[i];
+        if (command.Type == RENDER_SPRITE)
+        {
+            if (commands.Sprites[command.Index].Alpha <= 0.0f)
+                continue;
+            commands.Sprites[spriteCount] = commands.Sprites[command.Index];
+            command.Index = static_cast<unsigned int>(spriteCount++);
+        }
+        commands.Commands[commandCount++] = command;
+    }
+    commands.Commands.resize(commandCount);
+    commands.Sprites.resize(spriteCount);
+    return stats;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef RENDER_CULL_H
+#define RENDER_CULL_H
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "render_queue.h"
+
+// what one culling pass dropped; Submitted = Visible + the rest
+struct CullStats {
+    size_t Submitted;
+    size_t Transparent;     // zero alpha
+    size_t Offscreen;       // bounds outside the viewport
+    size_t Occluded;        // behind an opaque layer spanning the viewport width
+    size_t Visible;
+};
+
+// Removes sprite draws that cannot change a pixel of the viewport [viewMin, viewMax] from a
+// recorded frame, keeping the order of everything else. Occluders are later unrotated sprites
+// at full alpha that span the whole viewport width; the rows they cover come from the opaque
+// band of their texture's alpha mask (textures without a mask count as opaque). Text is kept.
+CullStats CullSprites(CommandBuffer& commands, glm::vec2 viewMin, glm::vec2 viewMax);
+
+#endif
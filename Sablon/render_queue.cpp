@@ -0,0 +1,147 @@
+#include "render_queue.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+
+CommandBuffer::CommandBuffer()
+    : Commands(ArenaAllocator<RenderCommand>(Arena)),
+    Sprites(ArenaAllocator<SpriteCommand>(Arena)),
+    Texts(ArenaAllocator<TextCommand>(Arena)),
+    Skies(ArenaAllocator<SkyCommand>(Arena)),
+    StarFields(ArenaAllocator<StarCommand>(Arena)),
+    ParticleSystems(ArenaAllocator<ParticleCommand>(Arena)) { }
+
+void CommandBuffer::Clear()
+{
+    // capacity rather than size: culling shrinks a recorded frame after it was filled
+    const size_t commandCount = Commands.capacity();
+    const size_t spriteCount = Sprites.capacity();
+    const size_t textCount = Texts.capacity();
+    const size_t skyCount = Skies.capacity();
+    const size_t starFieldCount = StarFields.capacity();
+    const size_t particleSystemCount = ParticleSystems.capacity();
+    // the vectors point into the arena, drop them before handing the memory out again
+    Commands = FrameVector<RenderCommand>(ArenaAllocator<RenderCommand>(Arena));
+    Sprites = FrameVector<SpriteCommand>(ArenaAllocator<SpriteCommand>(Arena));
+    Texts = FrameVector<TextCommand>(ArenaAllocator<TextCommand>(Arena));
+    Skies = FrameVector<SkyCommand>(ArenaAllocator<SkyCommand>(Arena));
+    StarFields = FrameVector<StarCommand>(ArenaAllocator<StarCommand>(Arena));
+    ParticleSystems = FrameVector<ParticleCommand>(ArenaAllocator<ParticleCommand>(Arena));
+    Arena.Reset();
+    Commands.reserve(commandCount);
+    Sprites.reserve(spriteCount);
+    Texts.reserve(textCount);
+    Skies.reserve(skyCount);
+    StarFields.reserve(starFieldCount);
+    ParticleSystems.reserve(particleSystemCount);
+}
+
+void CommandBuffer::PushSprite(const SpriteCommand& command)
+{
+    Commands.push_back({ RENDER_SPRITE, static_cast<unsigned int>(Sprites.size()) });
+    Sprites.push_back(command);
+}
+
+SpriteCommand* CommandBuffer::AllocateSprites(size_t count)
+{
+    const unsigned int first = static_cast<unsigned int>(Sprites.size());
+    Sprites.resize(first + count);
+    for (unsigned int i = 0; i < count; ++i)
+        Commands.push_back({ RENDER_SPRITE, first + i });
+    return Sprites.data() + first;
+}
+
+void CommandBuffer::PushText(const TextCommand& command)
+{
+    Commands.push_back({ RENDER_TEXT, static_cast<unsigned int>(Texts.size()) });
+    Texts.push_back(command);
+    Texts.back().Text = Arena.CopyString(command.Text, command.Length);
+}
+
+void CommandBuffer::PushSky(const SkyCommand& command)
+{
+    Commands.push_back({ RENDER_SKY, static_cast<unsigned int>(Skies.size()) });
+    Skies.push_back(command);
+}
+
+void CommandBuffer::PushStars(const StarCommand& command)
+{
+    Commands.push_back({ RENDER_STARS, static_cast<unsigned int>(StarFields.size()) });
+    StarFields.push_back(command);
+    if (command.Stars)
+    {
+        StarVertex* stars = static_cast<StarVertex*>(Arena.Allocate(command.Count * sizeof(StarVertex), alignof(StarVertex)));
+        std::memcpy(stars, command.Stars, command.Count * sizeof(StarVertex));
+        StarFields.back().Stars = stars;
+    }
+}
+
+void CommandBuffer::PushParticles(const ParticleCommand& command)
+{
+    Commands.push_back({ RENDER_PARTICLES, static_cast<unsigned int>(ParticleSystems.size()) });
+    ParticleSystems.push_back(command);
+}
+
+void CommandBuffer::BeginLayer(unsigned int layer)
+{
+    Commands.push_back({ RENDER_LAYER_BEGIN, layer });
+}
+
+void CommandBuffer::EndLayer()
+{
+    Commands.push_back({ RENDER_LAYER_END, 0 });
+}
+
+RenderQueue::RenderQueue()
+    : published(0), consumed(0), stopped(false), recording(0) { }
+
+CommandBuffer& RenderQueue::BeginFrame()
+{
+    recording = published.load(std::memory_order_relaxed) + 1;
+    // the buffer for frame N was last used by frame N-2, which must be drawn by now
+    int spins = 0;
+    while (recording > 2 && consumed.load(std::memory_order_acquire) < recording - 2 && !stopped.load(std::memory_order_relaxed))
+        wait(spins);
+    CommandBuffer& buffer = buffers[recording % 2];
+    buffer.Clear();
+    return buffer;
+}
+
+void RenderQueue::EndFrame()
+{
+    published.store(recording, std::memory_order_release);
+}
+
+const CommandBuffer* RenderQueue::AcquireFrame()
+{
+    const unsigned long long next = consumed.load(std::memory_order_relaxed) + 1;
+    int spins = 0;
+    while (published.load(std::memory_order_acquire) < next)
+    {
+        if (stopped.load(std::memory_order_relaxed))
+            return nullptr;
+        wait(spins);
+    }
+    return &buffers[next % 2];
+}
+
+void RenderQueue::ReleaseFrame()
+{
+    consumed.fetch_add(1, std::memory_order_release);
+}
+
+void RenderQueue::Shutdown()
+{
+    stopped.store(true);
+}
+
+void RenderQueue::wait(int& spins)
+{
+    // spin briefly for the common case of a nearly finished frame, then back off
+    if (++spins < 64)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
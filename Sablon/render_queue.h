@@ -0,0 +1,150 @@
+#pragma once
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <atomic>
+
+#include <glm/glm.hpp>
+
+#include "frame_arena.h"
+
+enum RenderCommandType {
+    RENDER_SPRITE,
+    RENDER_TEXT,
+    RENDER_SKY,
+    RENDER_STARS,
+    RENDER_PARTICLES,
+    RENDER_LAYER_BEGIN,     // Index is the cached layer; sprites up to the matching end belong to it
+    RENDER_LAYER_END
+};
+
+struct SpriteCommand {
+    unsigned int TextureID;
+    glm::vec2    Position;
+    glm::vec2    Size;
+    float        Rotation;
+    glm::vec3    Color;
+    float        Alpha;
+    bool         IsFlippedHorizontally;
+    float        Threshold;
+    glm::vec3    HighlightColor;
+};
+
+struct TextCommand {
+    const char* Text;       // owned by the command buffer's arena once pushed
+    size_t      Length;
+    float       X, Y, Scale;
+    glm::vec3   Color;
+    float       Alpha;
+    float       Threshold;
+};
+
+struct SkyCommand {
+    float     Daylight;     // 0 at night, 1 at noon
+    float     Horizon;      // world y the sun rises from
+    glm::vec2 SunPosition;  // center of the sun
+};
+
+struct StarVertex {
+    glm::vec2 Position;
+    float     Size;
+    float     Phase;        // twinkle offset in radians
+};
+
+struct StarCommand {
+    const StarVertex* Stars;    // only set on the frame the stars changed, then owned by the arena
+    size_t            Count;
+    float             Visibility;
+};
+
+constexpr unsigned int maxParticleEmitters = 8;
+
+// an emitter resolved to world space for one frame
+struct ParticleEmitterState {
+    glm::vec4 Area;         // spawn rectangle, min.xy and max.xy
+    glm::vec4 Velocity;     // base velocity.xy, random spread.xy
+    glm::vec2 Lifetime;     // min and max seconds
+    glm::vec2 Size;         // at birth and at death
+    glm::vec4 Color;
+    int       First;        // first particle it owns
+};
+
+struct ParticleCommand {
+    ParticleEmitterState Emitters[maxParticleEmitters];
+    unsigned int         EmitterCount;
+    unsigned int         ParticleCount;
+    float                Dt;
+    bool                 Reset;     // respawn every particle, set after emitters were added
+};
+
+// the FrameConstants uniform block every shader declares, laid out by std140 rules
+struct FrameConstants {
+    glm::mat4 Projection;
+    glm::mat4 View;
+    glm::vec2 ViewportSize; // pixels
+    float     Time;         // seconds of game time, drives the star twinkle
+    float     SunAngle;     // degrees
+};
+static_assert(sizeof(FrameConstants) == 144, "FrameConstants must match the std140 block");
+
+// one entry per draw in submission order, indexing into the typed arrays below
+struct RenderCommand {
+    RenderCommandType Type;
+    unsigned int      Index;
+};
+
+// everything the GL thread needs to draw one frame; filled by the simulation thread.
+// All storage comes from the buffer's own arena, so recording a frame does not hit the heap.
+class CommandBuffer
+{
+public:
+    CommandBuffer();
+    FrameArena                 Arena;
+    FrameVector<RenderCommand> Commands;
+    FrameVector<SpriteCommand> Sprites;
+    FrameVector<TextCommand>   Texts;
+    FrameVector<SkyCommand>    Skies;
+    FrameVector<StarCommand>   StarFields;
+    FrameVector<ParticleCommand> ParticleSystems;
+    // uploaded once before the frame's first draw
+    FrameConstants             Frame;
+    // releases last frame's commands, reserving room for as many again
+    void Clear();
+    void PushSprite(const SpriteCommand& command);
+    // appends count sprite draws at once; the caller fills the returned slots
+    SpriteCommand* AllocateSprites(size_t count);
+    // copies the text into the arena
+    void PushText(const TextCommand& command);
+    void PushSky(const SkyCommand& command);
+    // copies the star vertices into the arena when the command carries any
+    void PushStars(const StarCommand& command);
+    void PushParticles(const ParticleCommand& command);
+    // brackets sprite draws that are cached together in one offscreen texture
+    void BeginLayer(unsigned int layer);
+    void EndLayer();
+};
+
+// Double-buffered handoff between one producer (simulation) and one consumer (GL) thread.
+// The producer records frame N+1 while the consumer draws frame N; the producer only waits
+// when it is a whole frame ahead. Frames are counted, no mutex is taken.
+class RenderQueue
+{
+public:
+    RenderQueue();
+    // producer: returns the back buffer, cleared, once the consumer is done with it
+    CommandBuffer&       BeginFrame();
+    void                 EndFrame();
+    // consumer: waits for the next published frame, returns nullptr after Shutdown()
+    const CommandBuffer* AcquireFrame();
+    void                 ReleaseFrame();
+    void                 Shutdown();
+private:
+    CommandBuffer                       buffers[2];
+    std::atomic<unsigned long long>     published;
+    std::atomic<unsigned long long>     consumed;
+    std::atomic<bool>                   stopped;
+    unsigned long long                  recording;
+    static void wait(int& spins);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "render_thread.h"
+
+
+RenderThread::RenderThread(GLFWwindow* window, Game& game, RenderQueue& queue)
+    : window(window), game(game), queue(queue), viewportSize(0) { }
+
+RenderThread::~RenderThread()
+{
+    this->Stop();
+}
+
+void RenderThread::Start()
+{
+    this->thread = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::Stop()
+{
+    if (!this->thread.joinable())
+        return;
+    this->queue.Shutdown();
+    this->thread.join();
+}
+
+void RenderThread::Resize(int width, int height)
+{
+    this->viewportSize.store(static_cast<uint64_t>(static_cast<uint32_t>(width)) << 32 | static_cast<uint32_t>(height));
+}
+
+void RenderThread::run()
+{
+    glfwMakeContextCurrent(this->window);
+    while (const CommandBuffer* frame = this->queue.AcquireFrame())
+    {
+        const uint64_t size = this->viewportSize.exchange(0);
+        const int width = static_cast<int>(size >> 32);
+        const int height = static_cast<int>(size & 0xFFFFFFFFu);
+        if (size != 0)
+            glViewport(0, 0, width, height);
+
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        this->game.Execute(*frame);
+        // the commands are in the GL stream now, let the simulation reuse the buffer
+        this->queue.ReleaseFrame();
+
+        glfwSwapBuffers(this->window);
+    }
+    glfwMakeContextCurrent(NULL);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "Game.h"
+#include "render_queue.h"
+
+// Owns the GL context while running: draws the frames the simulation thread publishes
+// into the RenderQueue and swaps buffers, so update and GL submission overlap.
+class RenderThread
+{
+public:
+    RenderThread(GLFWwindow* window, Game& game, RenderQueue& queue);
+    ~RenderThread();
+    // the calling thread must release the context before Start() and may take it back after Stop()
+    void Start();
+    void Stop();
+    // safe to call from any thread, applied before the next frame
+    void Resize(int width, int height);
+private:
+    GLFWwindow*           window;
+    Game&                 game;
+    RenderQueue&          queue;
+    std::thread           thread;
+    // width in the high and height in the low 32 bits, so both change together; 0 when unchanged
+    std::atomic<uint64_t> viewportSize;
+    void run();
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "render_trace.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    const char     magic[4] = { 'E', 'G', 'R', 'T' };
+    // 2 added the frame constants to every frame
+    const uint32_t version = 2;
+
+    template <typename T>
+    void put(std::ofstream& output, const T& value)
+    {
+        output.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void putVec(std::ofstream& output, const float* values, int count)
+    {
+        output.write(reinterpret_cast<const char*>(values), count * sizeof(float));
+    }
+
+    template <typename T>
+    bool get(std::ifstream& input, T& value)
+    {
+        return static_cast<bool>(input.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    }
+
+    bool getVec(std::ifstream& input, float* values, int count)
+    {
+        return static_cast<bool>(input.read(reinterpret_cast<char*>(values), count * sizeof(float)));
+    }
+
+    void putFrame(std::ofstream& output, const FrameConstants& frame)
+    {
+        putVec(output, &frame.Projection[0].x, 16);
+        putVec(output, &frame.View[0].x, 16);
+        putVec(output, &frame.ViewportSize.x, 2);
+        put(output, frame.Time);
+        put(output, frame.SunAngle);
+    }
+
+    bool getFrame(std::ifstream& input, FrameConstants& frame)
+    {
+        getVec(input, &frame.Projection[0].x, 16);
+        getVec(input, &frame.View[0].x, 16);
+        getVec(input, &frame.ViewportSize.x, 2);
+        get(input, frame.Time);
+        return get(input, frame.SunAngle);
+    }
+}
+
+bool RenderTraceWriter::Open(const char* path, unsigned int width, unsigned int height, const std::vector<TraceTexture>& textures)
+{
+    this->output.open(path, std::ios::binary | std::ios::trunc);
+    if (!this->output)
+    {
+        std::cout << "ERROR::RENDER_TRACE: Failed to create " << path << std::endl;
+        return false;
+    }
+    this->output.write(magic, sizeof(magic));
+    put(this->output, version);
+    put(this->output, static_cast<uint32_t>(width));
+    put(this->output, static_cast<uint32_t>(height));
+    put(this->output, static_cast<uint32_t>(textures.size()));
+    for (const auto& texture : textures)
+    {
+        put(this->output, static_cast<uint32_t>(texture.ID));
+        put(this->output, static_cast<uint32_t>(texture.Width));
+        put(this->output, static_cast<uint32_t>(texture.Height));
+    }
+    return true;
+}
+
+void RenderTraceWriter::WriteFrame(const CommandBuffer& commands)
+{
+    if (!this->output.is_open())
+        return;
+    uint32_t count = 0;
+    for (const auto& command : commands.Commands)
+    {
+        if (command.Type == RENDER_SPRITE || command.Type == RENDER_TEXT)
+            count++;
+    }
+    put(this->output, count);
+    putFrame(this->output, commands.Frame);
+    for (const auto& command : commands.Commands)
+    {
+        if (command.Type == RENDER_SPRITE)
+        {
+            const SpriteCommand& sprite = commands.Sprites[command.Index];
+            put(this->output, static_cast<uint8_t>(RENDER_SPRITE));
+            put(this->output, static_cast<uint32_t>(sprite.TextureID));
+            putVec(this->output, &sprite.Position.x, 2);
+            putVec(this->output, &sprite.Size.x, 2);
+            put(this->output, sprite.Rotation);
+            putVec(this->output, &sprite.Color.x, 3);
+            put(this->output, sprite.Alpha);
+            put(this->output, static_cast<uint8_t>(sprite.IsFlippedHorizontally));
+            put(this->output, sprite.Threshold);
+            putVec(this->output, &sprite.HighlightColor.x, 3);
+        }
+        else if (command.Type == RENDER_TEXT)
+        {
+            const TextCommand& text = commands.Texts[command.Index];
+            put(this->output, static_cast<uint8_t>(RENDER_TEXT));
+            put(this->output, static_cast<uint32_t>(text.Length));
+            this->output.write(text.Text, text.Length);
+            put(this->output, text.X);
+            put(this->output, text.Y);
+            put(this->output, text.Scale);
+            putVec(this->output, &text.Color.x, 3);
+            put(this->output, text.Alpha);
+            put(this->output, text.Threshold);
+        }
+    }
+}
+
+void RenderTraceWriter::Close()
+{
+    if (this->output.is_open())
+        this->output.close();
+}
+
+bool RenderTrace::Load(const char* path)
+{
+    std::ifstream input(path, std::ios::binary);
+    char fileMagic[4] = {};
+    uint32_t fileVersion = 0, width = 0, height = 0, textureCount = 0;
+    input.read(fileMagic, sizeof(fileMagic));
+    get(input, fileVersion);
+    get(input, width);
+    get(input, height);
+    get(input, textureCount);
+    if (!input || std::memcmp(fileMagic, magic, sizeof(magic)) != 0)
+    {
+        std::cout << "ERROR::RENDER_TRACE: " << path << " is not a render trace" << std::endl;
+        return false;
+    }
+    if (fileVersion != version)
+    {
+        std::cout << "ERROR::RENDER_TRACE: " << path << " is a version " << fileVersion << " trace, record it again" << std::endl;
+        return false;
+    }
+    this->Width = width;
+    this->Height = height;
+    this->Textures.resize(textureCount);
+    for (auto& texture : this->Textures)
+    {
+        uint32_t id = 0, textureWidth = 0, textureHeight = 0;
+        get(input, id);
+        get(input, textureWidth);
+        get(input, textureHeight);
+        texture = { id, textureWidth, textureHeight };
+    }
+    this->Frames.clear();
+    uint32_t count = 0;
+    while (get(input, count))
+    {
+        TraceFrame frame;
+        if (!getFrame(input, frame.Frame))
+        {
+            std::cout << "ERROR::RENDER_TRACE: " << path << " is cut short" << std::endl;
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint8_t type = 0;
+            get(input, type);
+            if (type == RENDER_SPRITE)
+            {
+                SpriteCommand sprite;
+                uint32_t textureID = 0;
+                uint8_t flipped = 0;
+                get(input, textureID);
+                getVec(input, &sprite.Position.x, 2);
+                getVec(input, &sprite.Size.x, 2);
+                get(input, sprite.Rotation);
+                getVec(input, &sprite.Color.x, 3);
+                get(input, sprite.Alpha);
+                get(input, flipped);
+                get(input, sprite.Threshold);
+                getVec(input, &sprite.HighlightColor.x, 3);
+                sprite.TextureID = textureID;
+                sprite.IsFlippedHorizontally = flipped != 0;
+                frame.Commands.push_back({ RENDER_SPRITE, static_cast<unsigned int>(frame.Sprites.size()) });
+                frame.Sprites.push_back(sprite);
+            }
+            else if (type == RENDER_TEXT)
+            {
+                TextCommand text;
+                uint32_t length = 0;
+                get(input, length);
+                const size_t offset = frame.Characters.size();
+                frame.Characters.resize(offset + length);
+                input.read(&frame.Characters[offset], length);
+                text.Length = length;
+                get(input, text.X);
+                get(input, text.Y);
+                get(input, text.Scale);
+                getVec(input, &text.Color.x, 3);
+                get(input, text.Alpha);
+                get(input, text.Threshold);
+                frame.Commands.push_back({ RENDER_TEXT, static_cast<unsigned int>(frame.Texts.size()) });
+                frame.Texts.push_back(text);
+            }
+            if (!input)
+            {
+                std::cout << "ERROR::RENDER_TRACE: " << path << " is cut short" << std::endl;
+                return false;
+            }
+        }
+        this->Frames.push_back(std::move(frame));
+    }
+    // moving a short string moves its characters too, so the texts point into them only now
+    for (auto& frame : this->Frames)
+    {
+        size_t offset = 0;
+        for (auto& text : frame.Texts)
+        {
+            text.Text = frame.Characters.data() + offset;
+            offset += text.Length;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef RENDER_TRACE_H
+#define RENDER_TRACE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "render_queue.h"
+
+struct TraceTexture {
+    unsigned int ID;
+    unsigned int Width, Height;
+};
+
+// the sprite and text draws of one recorded frame, in submission order
+struct TraceFrame {
+    FrameConstants             Frame;       // the camera and viewport the draws were made through
+    std::vector<RenderCommand> Commands;    // RENDER_SPRITE and RENDER_TEXT only
+    std::vector<SpriteCommand> Sprites;
+    std::vector<TextCommand>   Texts;       // Text points into Characters, one text after another
+    std::string                Characters;
+};
+
+// Writes the sprite and text draws Game::Render submits, frame by frame, before culling, with
+// the frame constants they were drawn through, so a replay looks at the same part of the world.
+// Sky, stars, particles and layer brackets are left out; sprites inside a cached layer are
+// written as plain sprites. Fields are written one by one, so the file does not depend on
+// struct padding.
+class RenderTraceWriter
+{
+public:
+    bool Open(const char* path, unsigned int width, unsigned int height, const std::vector<TraceTexture>& textures);
+    void WriteFrame(const CommandBuffer& commands);
+    void Close();
+private:
+    std::ofstream output;
+};
+
+// a whole trace read back into memory for replaying
+class RenderTrace
+{
+public:
+    unsigned int              Width = 0, Height = 0;
+    std::vector<TraceTexture> Textures;
+    std::vector<TraceFrame>   Frames;
+    bool Load(const char* path);
+};
+
+#endif
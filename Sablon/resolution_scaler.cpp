@@ -0,0 +1,180 @@
+#include "resolution_scaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "memory_tracker.h"
+
+namespace
+{
+    // the share of the target frame time the GPU may take, the rest is left for the CPU and swaps
+    constexpr float gpuBudget = 0.85f;
+    // below this share of the budget the frame has headroom to draw more pixels
+    constexpr float headroom = 0.7f;
+    // frames with headroom in a row before the scale goes up a step
+    constexpr int   fastFramesToGrow = 30;
+    // the scale moves in steps, so the target and the cached layers are not resized every frame
+    constexpr float scaleSteps = 32.0f;
+    constexpr float growStep = 2.0f / scaleSteps;
+    // weight of the newest frame in the smoothed GPU time
+    constexpr float smoothing = 0.2f;
+}
+
+ResolutionScaler::ResolutionScaler(Shader& shader, float minScale, float maxScale, float targetFrameTime)
+    : query(0), targetFrameTime(targetFrameTime), gpuTime(0.0f), fastFrames(0),
+      windowSize(0, 0), textureSize(0, 0), size(0, 0)
+{
+    this->shader = shader;
+    this->minScale = std::max(minScale, 1.0f / scaleSteps);
+    this->maxScale = std::max(maxScale, this->minScale);
+    this->scale = this->maxScale;
+    glGenFramebuffers(1, &this->framebuffer);
+    glGenTextures(1, &this->texture);
+    glGenQueries(queryCount, this->queries);
+    for (int i = 0; i < queryCount; ++i)
+    {
+        this->issued[i] = false;
+        this->queryScales[i] = 0.0f;
+    }
+    // two triangles covering the screen in clip space
+    const float vertices[] = {
+        -1.0f, -1.0f,   1.0f, 1.0f,     -1.0f, 1.0f,
+        -1.0f, -1.0f,   1.0f, -1.0f,    1.0f, 1.0f
+    };
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    MemoryTracker::TrackBuffer(this->VBO, sizeof(vertices), MEMORY_RENDER_TARGETS);
+}
+
+ResolutionScaler::~ResolutionScaler()
+{
+    glDeleteFramebuffers(1, &this->framebuffer);
+    glDeleteTextures(1, &this->texture);
+    glDeleteQueries(queryCount, this->queries);
+    glDeleteVertexArrays(1, &this->VAO);
+    glDeleteBuffers(1, &this->VBO);
+    MemoryTracker::UntrackTexture(this->texture);
+    MemoryTracker::UntrackBuffer(this->VBO);
+}
+
+void ResolutionScaler::Begin(glm::vec2 windowSize)
+{
+    const glm::ivec2 window(static_cast<int>(windowSize.x), static_cast<int>(windowSize.y));
+    if (window.x != this->windowSize.x || window.y != this->windowSize.y)
+        this->resize(window);
+    this->readTimings();
+    // the target is drawn from its corner, so changing the scale never reallocates it
+    this->size = glm::ivec2(std::max(1, static_cast<int>(std::lround(window.x * this->scale))),
+                            std::max(1, static_cast<int>(std::lround(window.y * this->scale))));
+    glBeginQuery(GL_TIME_ELAPSED, this->queries[this->query]);
+    this->queryScales[this->query] = this->scale;
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glViewport(0, 0, this->size.x, this->size.y);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void ResolutionScaler::Resolve()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, this->windowSize.x, this->windowSize.y);
+    this->shader.Use();
+    this->shader.SetVector2f("sourceSize", glm::vec2(this->size.x, this->size.y));
+    this->shader.SetVector2f("textureSize", glm::vec2(this->textureSize.x, this->textureSize.y));
+    this->shader.SetVector2f("outputSize", glm::vec2(this->windowSize.x, this->windowSize.y));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, this->texture);
+    // the target is opaque and covers the window
+    glDisable(GL_BLEND);
+    glBindVertexArray(this->VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+    glEnable(GL_BLEND);
+}
+
+void ResolutionScaler::End()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    this->issued[this->query] = true;
+    this->query = (this->query + 1) % queryCount;
+}
+
+float ResolutionScaler::Scale() const
+{
+    return this->scale;
+}
+
+glm::vec2 ResolutionScaler::Size() const
+{
+    return glm::vec2(this->size.x, this->size.y);
+}
+
+void ResolutionScaler::readTimings()
+{
+    // the query about to be reused was issued a few frames ago, so its result is usually in
+    // without waiting; a result still in flight is dropped rather than stalling on it
+    const int oldest = this->query;
+    if (!this->issued[oldest])
+        return;
+    this->issued[oldest] = false;
+    GLint available = 0;
+    glGetQueryObjectiv(this->queries[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+    // frames drawn before the last scale change say nothing about the current one
+    if (!available || this->queryScales[oldest] != this->scale)
+        return;
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(this->queries[oldest], GL_QUERY_RESULT, &elapsed);
+    this->adjust(static_cast<float>(elapsed) * 1e-9f);
+}
+
+void ResolutionScaler::adjust(float frameTime)
+{
+    this->gpuTime = this->gpuTime > 0.0f ? this->gpuTime + smoothing * (frameTime - this->gpuTime) : frameTime;
+    const float budget = gpuBudget * this->targetFrameTime;
+    float scale = this->scale;
+    if (this->gpuTime > budget)
+    {
+        // the cost goes with the pixel count, the square of the scale
+        scale = std::floor(scale * std::sqrt(budget / this->gpuTime) * scaleSteps) / scaleSteps;
+        this->fastFrames = 0;
+    }
+    else if (this->gpuTime < headroom * budget && ++this->fastFrames >= fastFramesToGrow)
+    {
+        scale += growStep;
+        this->fastFrames = 0;
+    }
+    else if (this->gpuTime >= headroom * budget)
+        this->fastFrames = 0;
+    scale = std::min(std::max(scale, this->minScale), this->maxScale);
+    if (scale == this->scale)
+        return;
+    // expect the new cost until frames at the new scale are measured
+    this->gpuTime *= (scale * scale) / (this->scale * this->scale);
+    this->scale = scale;
+}
+
+void ResolutionScaler::resize(glm::ivec2 windowSize)
+{
+    this->windowSize = windowSize;
+    // large enough for the largest scale
+    this->textureSize = glm::ivec2(std::max(1, static_cast<int>(std::ceil(windowSize.x * this->maxScale))),
+                                   std::max(1, static_cast<int>(std::ceil(windowSize.y * this->maxScale))));
+    glBindTexture(GL_TEXTURE_2D, this->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, this->textureSize.x, this->textureSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->texture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    MemoryTracker::TrackTexture(this->texture, this->textureSize.x, this->textureSize.y, GL_RGBA, MEMORY_RENDER_TARGETS);
+}
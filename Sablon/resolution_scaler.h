@@ -0,0 +1,47 @@
+#pragma once
+#ifndef RESOLUTION_SCALER_H
+#define RESOLUTION_SCALER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+// Renders the scene into an offscreen target at a fraction of the window resolution and
+// scales it up to the window with a sharp filter. The fraction follows the GPU time of recent
+// frames, measured with timer queries, so the frame fits the target frame time: it drops as
+// soon as frames run long and climbs back slowly while they have headroom.
+class ResolutionScaler
+{
+public:
+    ResolutionScaler(Shader& shader, float minScale, float maxScale, float targetFrameTime);
+    ~ResolutionScaler();
+    // starts timing the frame and redirects drawing into the target, cleared, at the current scale
+    void      Begin(glm::vec2 windowSize);
+    // draws the target over the window; whatever is drawn after it is at native resolution
+    void      Resolve();
+    // stops timing the frame
+    void      End();
+    float     Scale() const;
+    // pixels drawn to this frame
+    glm::vec2 Size() const;
+private:
+    static constexpr int queryCount = 4;
+    Shader       shader;
+    unsigned int framebuffer, texture;
+    unsigned int VAO, VBO;
+    unsigned int queries[queryCount];
+    bool         issued[queryCount];
+    float        queryScales[queryCount];
+    int          query;
+    float        minScale, maxScale, targetFrameTime;
+    float        scale;
+    float        gpuTime;
+    int          fastFrames;
+    glm::ivec2   windowSize, textureSize, size;
+    void readTimings();
+    void adjust(float frameTime);
+    void resize(glm::ivec2 windowSize);
+};
+
+#endif
@@ -3,17 +3,24 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <thread>
 
 #include "stb_image.h"
+#include "memory_tracker.h"
+#include "shader_cache.h"
+#include "frame_constants.h"
 
 // Instantiate static variables
 std::map<std::string, Texture2D>    ResourceManager::Textures;
 std::map<std::string, Shader>       ResourceManager::Shaders;
+std::map<unsigned int, AlphaMask>   ResourceManager::AlphaMasks;
+std::vector<ResourceManager::PendingShader> ResourceManager::pendingShaders;
 
 
-Shader ResourceManager::LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name)
+Shader ResourceManager::LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name, const std::vector<std::string>& defines)
 {
-    Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
+    MemoryScope scope(MEMORY_RESOURCES);
+    Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile, defines);
     return Shaders[name];
 }
 
@@ -22,8 +29,80 @@ Shader& ResourceManager::GetShader(std::string name)
     return Shaders[name];
 }
 
+void ResourceManager::SubmitShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name, const std::vector<std::string>& defines)
+{
+    MemoryScope scope(MEMORY_RESOURCES);
+    const std::string vertexCode = addDefines(readFile(vShaderFile), defines);
+    const std::string fragmentCode = addDefines(readFile(fShaderFile), defines);
+    const std::string geometryCode = gShaderFile != nullptr ? addDefines(readFile(gShaderFile), defines) : std::string();
+    const char* geometrySource = gShaderFile != nullptr ? geometryCode.c_str() : nullptr;
+    const uint64_t key = ShaderCache::Key({ "graphics", vertexCode.c_str(), fragmentCode.c_str(), geometrySource });
+    if (ShaderCache::Load(key, Shaders[name].ID))
+    {
+        FrameConstantsBuffer::Attach(Shaders[name].ID);
+        return;
+    }
+    Shaders[name].Submit(vertexCode.c_str(), fragmentCode.c_str(), geometrySource);
+    pendingShaders.push_back({ name, key });
+}
+
+void ResourceManager::FinishShaders()
+{
+    while (!pendingShaders.empty())
+    {
+        bool finished = false;
+        for (size_t i = 0; i < pendingShaders.size();)
+        {
+            Shader& shader = Shaders[pendingShaders[i].Name];
+            if (!shader.Ready())
+            {
+                ++i;
+                continue;
+            }
+            shader.Finish();
+            ShaderCache::Store(pendingShaders[i].Key, shader.ID);
+            FrameConstantsBuffer::Attach(shader.ID);
+            pendingShaders.erase(pendingShaders.begin() + i);
+            finished = true;
+        }
+        if (!finished)
+            std::this_thread::yield();
+    }
+}
+
+Shader ResourceManager::LoadFeedbackShader(const char* vShaderFile, const char* const* varyings, int varyingCount, std::string name)
+{
+    MemoryScope scope(MEMORY_RESOURCES);
+    const std::string vertexCode = readFile(vShaderFile);
+    std::string captured;
+    for (int i = 0; i < varyingCount; ++i)
+        captured += std::string(varyings[i]) + '\n';
+    const uint64_t key = ShaderCache::Key({ "feedback", vertexCode.c_str(), captured.c_str() });
+    if (!ShaderCache::Load(key, Shaders[name].ID))
+    {
+        Shaders[name].CompileFeedback(vertexCode.c_str(), varyings, varyingCount);
+        ShaderCache::Store(key, Shaders[name].ID);
+    }
+    FrameConstantsBuffer::Attach(Shaders[name].ID);
+    return Shaders[name];
+}
+
+Shader ResourceManager::LoadComputeShader(const char* cShaderFile, std::string name)
+{
+    MemoryScope scope(MEMORY_RESOURCES);
+    const std::string computeCode = readFile(cShaderFile);
+    const uint64_t key = ShaderCache::Key({ "compute", computeCode.c_str() });
+    if (!ShaderCache::Load(key, Shaders[name].ID))
+    {
+        Shaders[name].CompileCompute(computeCode.c_str());
+        ShaderCache::Store(key, Shaders[name].ID);
+    }
+    return Shaders[name];
+}
+
 Texture2D ResourceManager::LoadTexture(const char* file, bool alpha, std::string name)
 {
+    MemoryScope scope(MEMORY_RESOURCES);
     Textures[name] = loadTextureFromFile(file, alpha);
     return Textures[name];
 }
@@ -33,6 +112,12 @@ Texture2D& ResourceManager::GetTexture(std::string name)
     return Textures[name];
 }
 
+const AlphaMask* ResourceManager::GetAlphaMask(unsigned int textureID)
+{
+    const auto found = AlphaMasks.find(textureID);
+    return found != AlphaMasks.end() ? &found->second : nullptr;
+}
+
 void ResourceManager::Clear()
 {
     // (properly) delete all shaders	
@@ -40,10 +125,14 @@ void ResourceManager::Clear()
         glDeleteProgram(iter.second.ID);
     // (properly) delete all textures
     for (auto iter : Textures)
+    {
         glDeleteTextures(1, &iter.second.ID);
+        MemoryTracker::UntrackTexture(iter.second.ID);
+    }
+    AlphaMasks.clear();
 }
 
-Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile)
+Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, const std::vector<std::string>& defines)
 {
     // 1. retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
@@ -78,12 +167,24 @@ Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char*
     {
         std::cout << "ERROR::SHADER: Failed to read shader files" << std::endl;
     }
+    // specialize the sources; the injected lines are part of the cache key like the rest
+    vertexCode = addDefines(vertexCode, defines);
+    fragmentCode = addDefines(fragmentCode, defines);
+    if (gShaderFile != nullptr)
+        geometryCode = addDefines(geometryCode, defines);
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
     const char* gShaderCode = geometryCode.c_str();
-    // 2. now create shader object from source code
+    // 2. now create shader object from source code, or take the program linked on an earlier run
     Shader shader;
-    shader.Compile(vShaderCode, fShaderCode, gShaderFile != nullptr ? gShaderCode : nullptr);
+    const uint64_t key = ShaderCache::Key({ "graphics", vShaderCode, fShaderCode, gShaderFile != nullptr ? gShaderCode : nullptr });
+    if (!ShaderCache::Load(key, shader.ID))
+    {
+        shader.Compile(vShaderCode, fShaderCode, gShaderFile != nullptr ? gShaderCode : nullptr);
+        ShaderCache::Store(key, shader.ID);
+    }
+    // block bindings are not part of a program binary, so they are set on every load
+    FrameConstantsBuffer::Attach(shader.ID);
     return shader;
 }
 
@@ -101,7 +202,39 @@ Texture2D ResourceManager::loadTextureFromFile(const char* file, bool alpha)
     unsigned char* data = stbi_load(file, &width, &height, &nrChannels, STBI_rgb_alpha);
     // now generate texture
     texture.Generate(width, height, data);
+    // keep a bit mask of the opaque pixels for picking
+    if (alpha && data)
+        AlphaMasks[texture.ID].Generate(data, width, height);
     // and finally free image data
     stbi_image_free(data);
     return texture;
+}
+
+std::string ResourceManager::readFile(const char* file)
+{
+    std::ifstream stream(file);
+    if (!stream)
+        std::cout << "ERROR::SHADER: Failed to read " << file << std::endl;
+    std::stringstream contents;
+    contents << stream.rdbuf();
+    return contents.str();
+}
+
+std::string ResourceManager::addDefines(const std::string& code, const std::vector<std::string>& defines)
+{
+    if (defines.empty())
+        return code;
+    // #version has to stay the first line
+    size_t start = 0;
+    if (code.compare(0, 8, "#version") == 0)
+    {
+        const size_t end = code.find('\n');
+        start = end != std::string::npos ? end + 1 : code.size();
+    }
+    std::string injected = code.substr(0, start);
+    for (const std::string& define : defines)
+        injected += "#define " + define + "\n";
+    // keep the line numbers in compile errors pointing at the file
+    injected += start > 0 ? "#line 2\n" : "#line 1\n";
+    return injected + code.substr(start);
 }
\ No newline at end of file
@@ -1,28 +1,49 @@
 #ifndef RESOURCE_MANAGER_H
 #define RESOURCE_MANAGER_H
 
+#include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <GL/glew.h>
 
 #include "texture.h"
-#include "shader.h"
+#include "Shader.h"
+#include "alpha_mask.h"
 
 class ResourceManager
 {
 public:
     static std::map<std::string, Shader>    Shaders;
     static std::map<std::string, Texture2D> Textures;
-    static Shader    LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name);
+    // coverage of every texture loaded with alpha, keyed by texture ID
+    static std::map<unsigned int, AlphaMask> AlphaMasks;
+    // defines are injected into every stage as "#define X", compiling a variant of the same sources
+    static Shader    LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name, const std::vector<std::string>& defines = {});
     static Shader&    GetShader(std::string name);
+    // starts compiling a program without waiting for it; it may not be used before FinishShaders()
+    static void      SubmitShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name, const std::vector<std::string>& defines = {});
+    // waits for every submitted program, reporting errors, taking them in the order they complete
+    static void      FinishShaders();
+    static Shader    LoadFeedbackShader(const char* vShaderFile, const char* const* varyings, int varyingCount, std::string name);
+    static Shader    LoadComputeShader(const char* cShaderFile, std::string name);
     static Texture2D LoadTexture(const char* file, bool alpha, std::string name);
     static Texture2D& GetTexture(std::string name);
+    // nullptr for textures without an alpha channel
+    static const AlphaMask* GetAlphaMask(unsigned int textureID);
     static void      Clear();
 private:
+    struct PendingShader {
+        std::string Name;
+        uint64_t    Key;    // in the shader cache
+    };
+    static std::vector<PendingShader> pendingShaders;
     ResourceManager() { }
-    static Shader    loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile = nullptr);
+    static Shader    loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile = nullptr, const std::vector<std::string>& defines = {});
     static Texture2D loadTextureFromFile(const char* file, bool alpha);
+    static std::string readFile(const char* file);
+    static std::string addDefines(const std::string& code, const std::vector<std::string>& defines);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "shader_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include <GL/glew.h>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+std::string  ShaderCache::directory;
+std::string  ShaderCache::driver;
+bool         ShaderCache::enabled = false;
+unsigned int ShaderCache::Hits = 0;
+unsigned int ShaderCache::Misses = 0;
+
+namespace
+{
+    const char magic[4] = { 'E', 'G', 'P', 'B' };
+
+    uint64_t hashBytes(uint64_t hash, const char* bytes, size_t length)
+    {
+        // 64-bit FNV-1a
+        for (size_t i = 0; i < length; ++i)
+        {
+            hash ^= static_cast<unsigned char>(bytes[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    std::string glString(GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+}
+
+void ShaderCache::Init(const char* directory)
+{
+    GLint formats = 0;
+    if (GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    enabled = formats > 0;
+    if (!enabled)
+        return;
+    ShaderCache::directory = directory;
+    driver = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+#if defined(_WIN32)
+    _mkdir(directory);
+#else
+    mkdir(directory, 0755);
+#endif
+}
+
+bool ShaderCache::Enabled()
+{
+    return enabled;
+}
+
+uint64_t ShaderCache::Key(std::initializer_list<const char*> sources)
+{
+    uint64_t hash = hashBytes(14695981039346656037ULL, driver.data(), driver.size());
+    for (const char* source : sources)
+    {
+        // the terminator separates the strings, so moving text between them changes the key
+        if (source)
+            hash = hashBytes(hash, source, std::char_traits<char>::length(source));
+        hash = hashBytes(hash, "", 1);
+    }
+    return hash;
+}
+
+bool ShaderCache::Load(uint64_t key, unsigned int& program)
+{
+    if (!enabled)
+        return false;
+    std::ifstream file(pathOf(key), std::ios::binary);
+    char fileMagic[4] = {};
+    uint32_t format = 0, length = 0;
+    file.read(fileMagic, sizeof(fileMagic));
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    file.read(reinterpret_cast<char*>(&length), sizeof(length));
+    if (!file || std::char_traits<char>::compare(fileMagic, magic, sizeof(magic)) != 0)
+    {
+        Misses++;
+        return false;
+    }
+    // the length comes from disk, so a truncated or foreign file must not size the allocation
+    const std::streampos start = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::streamoff remaining = file.tellg() - start;
+    file.seekg(start);
+    if (!file || remaining < 0 || static_cast<unsigned long long>(remaining) < length)
+    {
+        Misses++;
+        return false;
+    }
+    std::vector<char> binary(length);
+    if (!file.read(binary.data(), length))
+    {
+        Misses++;
+        return false;
+    }
+    program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        // a driver may reject its own binaries, for example after an update that kept the version string
+        glDeleteProgram(program);
+        Misses++;
+        return false;
+    }
+    Hits++;
+    return true;
+}
+
+void ShaderCache::Store(uint64_t key, unsigned int program)
+{
+    if (!enabled)
+        return;
+    GLint length = 0, linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!linked || length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    std::ofstream file(pathOf(key), std::ios::binary | std::ios::trunc);
+    const uint32_t fileFormat = format, fileLength = static_cast<uint32_t>(length);
+    file.write(magic, sizeof(magic));
+    file.write(reinterpret_cast<const char*>(&fileFormat), sizeof(fileFormat));
+    file.write(reinterpret_cast<const char*>(&fileLength), sizeof(fileLength));
+    file.write(binary.data(), length);
+}
+
+std::string ShaderCache::pathOf(uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%016llx.bin", static_cast<unsigned long long>(key));
+    return directory + name;
+}
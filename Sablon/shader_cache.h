@@ -0,0 +1,33 @@
+#pragma once
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// Linked programs saved with glGetProgramBinary and loaded back with glProgramBinary on the
+// next launch. Keys hash every source string and the driver's vendor, renderer and version,
+// so editing a shader or updating the driver falls back to compiling. Disabled until Init()
+// finds program binary support.
+class ShaderCache
+{
+public:
+    // call once with a current context; the directory is created when missing
+    static void     Init(const char* directory);
+    static bool     Enabled();
+    // null entries are skipped but still change the key
+    static uint64_t Key(std::initializer_list<const char*> sources);
+    // a linked program on success; false means compile the sources instead
+    static bool     Load(uint64_t key, unsigned int& program);
+    static void     Store(uint64_t key, unsigned int program);
+    static unsigned int Hits, Misses;
+private:
+    static std::string directory;
+    static std::string driver;      // vendor, renderer and version strings
+    static bool        enabled;
+    ShaderCache() { }
+    static std::string pathOf(uint64_t key);
+};
+
+#endif
@@ -0,0 +1,26 @@
+#version 330 core
+in vec2 WorldPosition;
+out vec4 color;
+
+uniform float daylight;      // 0 at night, 1 with the sun at its highest
+uniform float horizon;       // world y the sun rises from
+uniform vec2  sunPosition;   // center of the sun in world space
+
+const vec3 nightZenith = vec3(0.0, 0.0, 0.3);
+const vec3 dayZenith = vec3(0.5, 0.7, 1.0);
+const vec3 nightHorizon = vec3(0.05, 0.08, 0.4);
+const vec3 dayHorizon = vec3(0.8, 0.9, 1.0);
+const vec3 duskGlow = vec3(1.0, 0.5, 0.2);
+
+void main()
+{
+    // 0 at the top of the screen, 1 at the horizon
+    float height = clamp(WorldPosition.y / horizon, 0.0, 1.0);
+    vec3 sky = mix(mix(nightZenith, dayZenith, daylight), mix(nightHorizon, dayHorizon, daylight), height * height);
+
+    // warm glow around the sun while it is close to the horizon
+    float dusk = 1.0 - smoothstep(0.0, 0.3, abs(horizon - sunPosition.y) / horizon);
+    float glow = exp(-length(WorldPosition - sunPosition) / (0.6 * horizon));
+    sky += duskGlow * dusk * glow * height;
+    color = vec4(sky, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec2 vertex; // clip-space corner of the screen quad
+
+out vec2 WorldPosition;
+
+// per-frame constants shared by every program, see FrameConstants in render_queue.h
+layout (std140) uniform FrameConstants
+{
+    mat4  projection;
+    mat4  view;
+    vec2  viewportSize;     // pixels
+    float time;             // seconds of game time
+    float sunAngle;         // degrees
+};
+
+void main()
+{
+    WorldPosition = (inverse(projection * view) * vec4(vertex, 0.0, 1.0)).xy;
+    gl_Position = vec4(vertex, 0.0, 1.0);
+}
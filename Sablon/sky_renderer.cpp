@@ -0,0 +1,62 @@
+#include "sky_renderer.h"
+
+#include "memory_tracker.h"
+
+SkyRenderer::SkyRenderer(Shader& shader)
+{
+    this->shader = shader;
+    // two triangles covering the screen in clip space; the shader finds the world under them
+    const float vertices[] = {
+        -1.0f, -1.0f,   1.0f, 1.0f,     -1.0f, 1.0f,
+        -1.0f, -1.0f,   1.0f, -1.0f,    1.0f, 1.0f
+    };
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    MemoryTracker::TrackBuffer(this->VBO, sizeof(vertices), MEMORY_SPRITES);
+}
+
+SkyRenderer::~SkyRenderer()
+{
+    glDeleteVertexArrays(1, &this->VAO);
+    glDeleteBuffers(1, &this->VBO);
+    MemoryTracker::UntrackBuffer(this->VBO);
+}
+
+void SkyRenderer::Begin(CommandBuffer& commands)
+{
+    this->recording = &commands;
+}
+
+void SkyRenderer::End()
+{
+    this->recording = nullptr;
+}
+
+void SkyRenderer::Draw(const SkyCommand& command)
+{
+    if (this->recording)
+        this->recording->PushSky(command);
+    else
+        this->Execute(command);
+}
+
+void SkyRenderer::Execute(const SkyCommand& command)
+{
+    this->shader.Use();
+    this->shader.SetFloat("daylight", command.Daylight);
+    this->shader.SetFloat("horizon", command.Horizon);
+    this->shader.SetVector2f("sunPosition", command.SunPosition);
+    // the sky replaces whatever is below it, no need to blend
+    glDisable(GL_BLEND);
+    glBindVertexArray(this->VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+    glEnable(GL_BLEND);
+}
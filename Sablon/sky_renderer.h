@@ -0,0 +1,29 @@
+#pragma once
+#ifndef SKY_RENDERER_H
+#define SKY_RENDERER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "render_queue.h"
+
+// Draws the sky as one full-screen pass with the day/night gradient computed in the fragment
+// shader, so there are no texture reads. It covers the viewport wherever the camera is.
+class SkyRenderer
+{
+public:
+    explicit SkyRenderer(Shader& shader);
+    ~SkyRenderer();
+    // while recording, Draw appends to the command buffer instead of issuing GL calls
+    void Begin(CommandBuffer& commands);
+    void End();
+    void Draw(const SkyCommand& command);
+    void Execute(const SkyCommand& command);
+private:
+    Shader         shader;
+    unsigned int   VAO, VBO;
+    CommandBuffer* recording = nullptr;
+};
+
+#endif
@@ -0,0 +1,277 @@
+#include "spatial_grid.h"
+
+#include <cmath>
+
+#include "game_object.h"
+
+// past this many cells a rect query scans the entries instead of the cells
+constexpr long long maxQueryCells = 4096;
+
+SpatialGrid::SpatialGrid(float cellSize, unsigned int bucketCount)
+    : cellSize(cellSize), liveEntries(0), stamp(0)
+{
+    // round up to a power of two so a bucket is picked with a mask
+    unsigned int size = 1;
+    while (size < bucketCount)
+        size <<= 1;
+    this->bucketMask = size - 1;
+    this->buckets.assign(size, -1);
+}
+
+void SpatialGrid::Insert(GameObject* object, unsigned int layers)
+{
+    int index = this->findEntry(object);
+    if (index >= 0)
+    {
+        this->entries[index].Layers = layers;
+        this->Refresh(object);
+        return;
+    }
+    if (!this->freeEntries.empty())
+    {
+        index = this->freeEntries.back();
+        this->freeEntries.pop_back();
+    }
+    else
+    {
+        index = static_cast<int>(this->entries.size());
+        this->entries.push_back(Entry());
+    }
+    this->entryOf[object] = index;
+    Entry& entry = this->entries[index];
+    entry.Object = object;
+    entry.Layers = layers;
+    entry.FirstNode = -1;
+    entry.Stamp = 0;
+    this->updateBounds(entry);
+    this->link(index);
+    this->liveEntries++;
+}
+
+void SpatialGrid::Remove(GameObject* object)
+{
+    const int index = this->findEntry(object);
+    if (index < 0)
+        return;
+    this->unlink(index);
+    this->entries[index].Object = nullptr;
+    this->entryOf.erase(object);
+    this->freeEntries.push_back(index);
+    this->liveEntries--;
+}
+
+void SpatialGrid::Refresh(GameObject* object)
+{
+    const int index = this->findEntry(object);
+    if (index < 0)
+        return;
+    Entry& entry = this->entries[index];
+    if (entry.Position == object->Position && entry.Size == object->Size && entry.Rotation == object->Rotation)
+        return;
+    const glm::vec2 oldMin = entry.Min, oldMax = entry.Max;
+    this->updateBounds(entry);
+    // moving inside the same cells only needs the new bounds
+    if (this->cellOf(oldMin.x) == this->cellOf(entry.Min.x) && this->cellOf(oldMin.y) == this->cellOf(entry.Min.y)
+        && this->cellOf(oldMax.x) == this->cellOf(entry.Max.x) && this->cellOf(oldMax.y) == this->cellOf(entry.Max.y))
+        return;
+    this->unlink(index);
+    this->link(index);
+}
+
+void SpatialGrid::Clear()
+{
+    this->buckets.assign(this->buckets.size(), -1);
+    this->nodes.clear();
+    this->entries.clear();
+    this->freeNodes.clear();
+    this->freeEntries.clear();
+    this->entryOf.clear();
+    this->liveEntries = 0;
+}
+
+void SpatialGrid::QueryPoint(glm::vec2 point, unsigned int layers, std::vector<GameObject*>& results) const
+{
+    ++this->stamp;
+    this->visitCell(this->cellOf(point.x), this->cellOf(point.y), layers, [&](const Entry& entry) {
+        if (point.x >= entry.Min.x && point.x <= entry.Max.x && point.y >= entry.Min.y && point.y <= entry.Max.y)
+        {
+            entry.Stamp = this->stamp;
+            results.push_back(entry.Object);
+        }
+    });
+}
+
+void SpatialGrid::QueryRect(glm::vec2 min, glm::vec2 max, unsigned int layers, std::vector<GameObject*>& results) const
+{
+    ++this->stamp;
+    auto overlaps = [&](const Entry& entry) {
+        return entry.Min.x <= max.x && entry.Max.x >= min.x && entry.Min.y <= max.y && entry.Max.y >= min.y;
+    };
+    const int minX = this->cellOf(min.x), maxX = this->cellOf(max.x);
+    const int minY = this->cellOf(min.y), maxY = this->cellOf(max.y);
+    const long long cellCount = static_cast<long long>(maxX - minX + 1) * (maxY - minY + 1);
+    if (cellCount > maxQueryCells || cellCount > static_cast<long long>(this->liveEntries))
+    {
+        for (const auto& entry : this->entries)
+        {
+            if (entry.Object && (entry.Layers & layers) && overlaps(entry))
+                results.push_back(entry.Object);
+        }
+        return;
+    }
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            this->visitCell(x, y, layers, [&](const Entry& entry) {
+                if (overlaps(entry))
+                {
+                    entry.Stamp = this->stamp;
+                    results.push_back(entry.Object);
+                }
+            });
+        }
+    }
+}
+
+GameObject* SpatialGrid::Nearest(glm::vec2 point, unsigned int layers, float maxDistance) const
+{
+    ++this->stamp;
+    GameObject* nearest = nullptr;
+    float bestDistance = maxDistance;
+    const int centerX = this->cellOf(point.x), centerY = this->cellOf(point.y);
+    const int maxRing = static_cast<int>(std::ceil(maxDistance / this->cellSize));
+    for (int ring = 0; ring <= maxRing; ++ring)
+    {
+        // everything in this ring is at least (ring - 1) cells away
+        if (nearest && (ring - 1) * this->cellSize > bestDistance)
+            break;
+        for (int y = centerY - ring; y <= centerY + ring; ++y)
+        {
+            for (int x = centerX - ring; x <= centerX + ring; ++x)
+            {
+                if (std::abs(x - centerX) != ring && std::abs(y - centerY) != ring)
+                    continue;
+                this->visitCell(x, y, layers, [&](const Entry& entry) {
+                    entry.Stamp = this->stamp;
+                    const float dx = std::fmax(std::fmax(entry.Min.x - point.x, point.x - entry.Max.x), 0.0f);
+                    const float dy = std::fmax(std::fmax(entry.Min.y - point.y, point.y - entry.Max.y), 0.0f);
+                    const float distance = std::sqrt(dx * dx + dy * dy);
+                    if (distance <= bestDistance)
+                    {
+                        bestDistance = distance;
+                        nearest = entry.Object;
+                    }
+                });
+            }
+        }
+    }
+    return nearest;
+}
+
+size_t SpatialGrid::Size() const
+{
+    return this->liveEntries;
+}
+
+int SpatialGrid::findEntry(const GameObject* object) const
+{
+    const auto found = this->entryOf.find(object);
+    return found != this->entryOf.end() ? found->second : -1;
+}
+
+void SpatialGrid::link(int index)
+{
+    Entry& entry = this->entries[index];
+    const int minX = this->cellOf(entry.Min.x), maxX = this->cellOf(entry.Max.x);
+    const int minY = this->cellOf(entry.Min.y), maxY = this->cellOf(entry.Max.y);
+    for (int y = minY; y <= maxY; ++y)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            int node;
+            if (!this->freeNodes.empty())
+            {
+                node = this->freeNodes.back();
+                this->freeNodes.pop_back();
+            }
+            else
+            {
+                node = static_cast<int>(this->nodes.size());
+                this->nodes.push_back(Node());
+            }
+            const int bucket = this->bucketOf(x, y);
+            Node& filed = this->nodes[node];
+            filed.Entry = index;
+            filed.Bucket = bucket;
+            filed.Previous = -1;
+            filed.Next = this->buckets[bucket];
+            if (filed.Next >= 0)
+                this->nodes[filed.Next].Previous = node;
+            this->buckets[bucket] = node;
+            filed.NextOfEntry = entry.FirstNode;
+            entry.FirstNode = node;
+        }
+    }
+}
+
+void SpatialGrid::unlink(int index)
+{
+    Entry& entry = this->entries[index];
+    int node = entry.FirstNode;
+    while (node >= 0)
+    {
+        const Node& filed = this->nodes[node];
+        if (filed.Previous >= 0)
+            this->nodes[filed.Previous].Next = filed.Next;
+        else
+            this->buckets[filed.Bucket] = filed.Next;
+        if (filed.Next >= 0)
+            this->nodes[filed.Next].Previous = filed.Previous;
+        this->freeNodes.push_back(node);
+        node = filed.NextOfEntry;
+    }
+    entry.FirstNode = -1;
+}
+
+void SpatialGrid::updateBounds(Entry& entry) const
+{
+    const GameObject* object = entry.Object;
+    entry.Position = object->Position;
+    entry.Size = object->Size;
+    entry.Rotation = object->Rotation;
+    glm::vec2 half = 0.5f * object->Size;
+    if (object->Rotation != 0.0f)
+    {
+        // bounds of the rectangle rotated around its center, as SpriteRenderer draws it
+        const float radians = glm::radians(object->Rotation);
+        const float c = std::fabs(std::cos(radians)), s = std::fabs(std::sin(radians));
+        half = glm::vec2(c * half.x + s * half.y, s * half.x + c * half.y);
+    }
+    const glm::vec2 center = object->Position + 0.5f * object->Size;
+    entry.Min = center - half;
+    entry.Max = center + half;
+}
+
+int SpatialGrid::cellOf(float coordinate) const
+{
+    return static_cast<int>(std::floor(coordinate / this->cellSize));
+}
+
+int SpatialGrid::bucketOf(int cellX, int cellY) const
+{
+    const unsigned int hash = static_cast<unsigned int>(cellX) * 73856093u ^ static_cast<unsigned int>(cellY) * 19349663u;
+    return static_cast<int>(hash & this->bucketMask);
+}
+
+template <typename Visit>
+void SpatialGrid::visitCell(int cellX, int cellY, unsigned int layers, Visit visit) const
+{
+    for (int node = this->buckets[this->bucketOf(cellX, cellY)]; node >= 0; node = this->nodes[node].Next)
+    {
+        const Entry& entry = this->entries[this->nodes[node].Entry];
+        // other cells hash to the same bucket too; the bounds tests in the callers reject them
+        if ((entry.Layers & layers) && entry.Stamp != this->stamp)
+            visit(entry);
+    }
+}
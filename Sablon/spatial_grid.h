@@ -0,0 +1,68 @@
+#pragma once
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class GameObject;
+
+// Uniform spatial hash over object bounds. Cells are hashed into a fixed number of buckets,
+// each an intrusive list of nodes taken from a pool, so moving objects does not allocate once
+// the pool has grown. Every object carries a layer mask that queries filter on.
+// Not thread-safe: refresh and query from one thread at a time.
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(float cellSize = 128.0f, unsigned int bucketCount = 4096);
+    void        Insert(GameObject* object, unsigned int layers);
+    void        Remove(GameObject* object);
+    // re-files the object if its Position, Size or Rotation changed since the last refresh
+    void        Refresh(GameObject* object);
+    void        Clear();
+    // results are appended, each object at most once
+    void        QueryPoint(glm::vec2 point, unsigned int layers, std::vector<GameObject*>& results) const;
+    void        QueryRect(glm::vec2 min, glm::vec2 max, unsigned int layers, std::vector<GameObject*>& results) const;
+    // closest object by distance from point to its bounds, nullptr if none within maxDistance
+    GameObject* Nearest(glm::vec2 point, unsigned int layers, float maxDistance) const;
+    size_t      Size() const;
+private:
+    struct Entry {
+        GameObject*          Object;
+        unsigned int         Layers;
+        glm::vec2            Min, Max;
+        glm::vec2            Position, Size;
+        float                Rotation;
+        int                  FirstNode;
+        mutable unsigned int Stamp;
+    };
+    struct Node {
+        int Entry;
+        int Bucket;
+        int Previous, Next;     // within the bucket
+        int NextOfEntry;        // all nodes of one entry
+    };
+    float                   cellSize;
+    unsigned int            bucketMask;
+    std::vector<int>        buckets;
+    std::vector<Node>       nodes;
+    std::vector<Entry>      entries;
+    std::vector<int>        freeNodes;
+    std::vector<int>        freeEntries;
+    std::unordered_map<const GameObject*, int> entryOf;
+    size_t                  liveEntries;
+    mutable unsigned int    stamp;
+    int  findEntry(const GameObject* object) const;
+    void link(int entry);
+    void unlink(int entry);
+    void updateBounds(Entry& entry) const;
+    int  cellOf(float coordinate) const;
+    int  bucketOf(int cellX, int cellY) const;
+    // visits the entries filed in one cell that match layers and have not been seen this query
+    template <typename Visit>
+    void visitCell(int cellX, int cellY, unsigned int layers, Visit visit) const;
+};
+
+#endif
@@ -1,18 +1,23 @@
 #version 330 core
+// features, compiled in with #define: HIGHLIGHT tints the texels left of a threshold
 in vec2 TexCoords;
+in vec4 SpriteColor;
+#ifdef HIGHLIGHT
+in vec4 Highlight;
+#endif
 out vec4 color;
 
 uniform sampler2D sprite;
-uniform vec3 spriteColor;
-uniform float alpha = 1.0f;
-uniform float threshold = 0.0f;
-uniform vec3 highlightColor = vec3(1.0f, 0.0f, 0.0f);  
 
 void main()
 {
-    if (TexCoords.x < threshold) {  // Compare x component of TexCoords to 0.5
-        color = vec4(highlightColor, alpha) * texture(sprite, TexCoords);
+#ifdef HIGHLIGHT
+    if (TexCoords.x < Highlight.w) {  // Highlight.w is the threshold
+        color = vec4(Highlight.rgb, SpriteColor.a) * texture(sprite, TexCoords);
     } else {
-        color = vec4(spriteColor, alpha) * texture(sprite, TexCoords);
+        color = SpriteColor * texture(sprite, TexCoords);
     }
+#else
+    color = SpriteColor * texture(sprite, TexCoords);
+#endif
 }
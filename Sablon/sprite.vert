@@ -1,14 +1,32 @@
 #version 330 core
+// features, compiled in with #define: HIGHLIGHT tints the texels left of a threshold
 layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec4 color; // <vec3 spriteColor, float alpha>
+layout (location = 2) in vec4 highlight; // <vec3 highlightColor, float threshold>
 
 out vec2 TexCoords;
+out vec4 SpriteColor;
+#ifdef HIGHLIGHT
+out vec4 Highlight;
+#endif
 
-uniform mat4 model;
-// note that we're omitting the view matrix; the view never changes so we basically have an identity view matrix and can therefore omit it.
-uniform mat4 projection;
+// positions arrive in world space from the sprite batch, so there is no model matrix.
+// per-frame constants shared by every program, see FrameConstants in render_queue.h
+layout (std140) uniform FrameConstants
+{
+    mat4  projection;
+    mat4  view;
+    vec2  viewportSize;     // pixels
+    float time;             // seconds of game time
+    float sunAngle;         // degrees
+};
 
 void main()
 {
     TexCoords = vertex.zw;
-    gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
-}
\ No newline at end of file
+    SpriteColor = color;
+#ifdef HIGHLIGHT
+    Highlight = highlight;
+#endif
+    gl_Position = projection * view * vec4(vertex.xy, 0.0, 1.0);
+}
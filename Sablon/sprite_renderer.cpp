@@ -1,75 +1,165 @@
 #include "sprite_renderer.h"
 
+#include <cstddef>
 
-SpriteRenderer::SpriteRenderer(Shader& shader)
+#include "sprite_transform.h"
+#include "memory_tracker.h"
+
+// sprites per vertex buffer upload; the static index buffer covers this many quads
+constexpr size_t maxBatchSprites = 16384;
+
+SpriteRenderer::SpriteRenderer(Shader& shader, Shader& highlightShader)
 {
+    MemoryScope scope(MEMORY_SPRITES);
     this->shader = shader;
+    this->highlightShader = highlightShader;
     this->initRenderData();
 }
 
 SpriteRenderer::~SpriteRenderer()
 {
     glDeleteVertexArrays(1, &this->quadVAO);
+    glDeleteBuffers(1, &this->quadVBO);
+    glDeleteBuffers(1, &this->quadEBO);
+    MemoryTracker::UntrackBuffer(this->quadVBO);
+    MemoryTracker::UntrackBuffer(this->quadEBO);
 }
 
-void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color, float alpha, bool isFlippedHorizontally, float threshold, glm::vec3 highlightColor)
+void SpriteRenderer::Begin(CommandBuffer& commands)
 {
-    this->shader.Use();
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(position, 0.0f));  
-
-    model = glm::translate(model, glm::vec3(0.5f * size.x, 0.5f * size.y, 0.0f)); 
-    model = glm::rotate(model, glm::radians(rotate), glm::vec3(0.0f, 0.0f, 1.0f)); 
-    if (isFlippedHorizontally)
-    {
-        model = glm::scale(model, glm::vec3(-1.0f, 1.0f, 1.0f));  
-    }
-
-	model = glm::translate(model, glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f)); 
+    this->recording = &commands;
+}
 
-    model = glm::scale(model, glm::vec3(size, 1.0f)); 
+void SpriteRenderer::End()
+{
+    this->recording = nullptr;
+}
 
-    this->shader.SetMatrix4("model", model);
+void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color, float alpha, bool isFlippedHorizontally, float threshold, glm::vec3 highlightColor)
+{
+    const SpriteCommand command = { texture.ID, position, size, rotate, color, alpha, isFlippedHorizontally, threshold, highlightColor };
+    if (this->recording)
+        this->recording->PushSprite(command);
+    else
+        this->Execute(command);
+}
 
-    this->shader.SetVector3f("spriteColor", color);
+void SpriteRenderer::Execute(const SpriteCommand& command)
+{
+    this->DrawBatch(&command, 1);
+}
 
-    this->shader.SetFloat("alpha", alpha);
+void SpriteRenderer::DrawBatch(const SpriteCommand* sprites, size_t count)
+{
+    if (count == 0)
+        return;
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(this->quadVAO);
+    for (size_t first = 0; first < count; first += maxBatchSprites)
+        this->drawChunk(sprites + first, count - first < maxBatchSprites ? count - first : maxBatchSprites);
+    glBindVertexArray(0);
+}
 
-    this->shader.SetFloat("threshold", threshold);
-    this->shader.SetVector3f("highlightColor", highlightColor);
+void SpriteRenderer::drawChunk(const SpriteCommand* sprites, size_t count)
+{
+    MemoryScope scope(MEMORY_SPRITES);
+    // gather the transforms into arrays the SIMD kernel can stream through
+    positionX.resize(count);
+    positionY.resize(count);
+    width.resize(count);
+    height.resize(count);
+    rotation.resize(count);
+    flip.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        positionX[i] = sprites[i].Position.x;
+        positionY[i] = sprites[i].Position.y;
+        width[i] = sprites[i].Size.x;
+        height[i] = sprites[i].Size.y;
+        rotation[i] = sprites[i].Rotation;
+        flip[i] = sprites[i].IsFlippedHorizontally ? 1 : 0;
+    }
+    corners.resize(4 * count);
+    const SpriteTransforms transforms = { positionX.data(), positionY.data(), width.data(), height.data(), rotation.data(), flip.data(), count };
+    TransformSprites(transforms, corners.data());
 
+    static const glm::vec2 texCoords[4] = {
+        glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f)
+    };
+    vertices.resize(4 * count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const glm::vec4 color(sprites[i].Color, sprites[i].Alpha);
+        const glm::vec4 highlight(sprites[i].HighlightColor, sprites[i].Threshold);
+        for (size_t corner = 0; corner < 4; ++corner)
+            vertices[4 * i + corner] = { corners[4 * i + corner], texCoords[corner], color, highlight };
+    }
 
-    glActiveTexture(GL_TEXTURE0);
-    texture.Bind();
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+    // orphan the previous contents so the driver does not wait for the last draw
+    glBufferData(GL_ARRAY_BUFFER, maxBatchSprites * 4 * sizeof(Vertex), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glBindVertexArray(this->quadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    // one draw call per run of sprites sharing a texture, with the highlight variant
+    // only bound for runs that have a sprite with a threshold
+    GLuint program = 0;
+    size_t runStart = 0;
+    bool highlighted = sprites[0].Threshold > 0.0f;
+    for (size_t i = 1; i <= count; ++i)
+    {
+        if (i < count && sprites[i].TextureID == sprites[runStart].TextureID)
+        {
+            highlighted = highlighted || sprites[i].Threshold > 0.0f;
+            continue;
+        }
+        Shader& variant = highlighted ? this->highlightShader : this->shader;
+        if (variant.ID != program)
+        {
+            variant.Use();
+            program = variant.ID;
+        }
+        glBindTexture(GL_TEXTURE_2D, sprites[runStart].TextureID);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(6 * (i - runStart)), GL_UNSIGNED_INT,
+            reinterpret_cast<void*>(6 * runStart * sizeof(unsigned int)));
+        runStart = i;
+        highlighted = i < count && sprites[i].Threshold > 0.0f;
+    }
 }
 
 void SpriteRenderer::initRenderData()
 {
-    unsigned int VBO;
-    float vertices[] = {
-        // pos      // tex
-        0.0f, 1.0f, 0.0f, 1.0f,
-        1.0f, 0.0f, 1.0f, 0.0f,
-        0.0f, 0.0f, 0.0f, 0.0f,
-
-        0.0f, 1.0f, 0.0f, 1.0f,
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 0.0f, 1.0f, 0.0f
-    };
+    std::vector<unsigned int> indices(6 * maxBatchSprites);
+    for (unsigned int i = 0; i < maxBatchSprites; ++i)
+    {
+        // corners come in texture order (0,0) (1,0) (1,1) (0,1)
+        const unsigned int corner = 4 * i;
+        indices[6 * i + 0] = corner + 0;
+        indices[6 * i + 1] = corner + 1;
+        indices[6 * i + 2] = corner + 2;
+        indices[6 * i + 3] = corner + 0;
+        indices[6 * i + 4] = corner + 2;
+        indices[6 * i + 5] = corner + 3;
+    }
 
     glGenVertexArrays(1, &this->quadVAO);
-    glGenBuffers(1, &VBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glGenBuffers(1, &this->quadVBO);
+    glGenBuffers(1, &this->quadEBO);
 
     glBindVertexArray(this->quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, maxBatchSprites * 4 * sizeof(Vertex), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->quadEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Highlight));
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
-}
\ No newline at end of file
+    MemoryTracker::TrackBuffer(this->quadVBO, maxBatchSprites * 4 * sizeof(Vertex), MEMORY_SPRITES);
+    MemoryTracker::TrackBuffer(this->quadEBO, indices.size() * sizeof(unsigned int), MEMORY_SPRITES);
+}
@@ -2,24 +2,49 @@
 #ifndef SPRITE_RENDERER_H
 #define SPRITE_RENDERER_H
 
+#include <vector>
+
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "texture.h"
-#include "shader.h"
+#include "Shader.h"
+#include "render_queue.h"
 
 
 class SpriteRenderer
 {
 public:
-    SpriteRenderer(Shader& shader);
+    // shader is the plain variant of sprite.vert/frag, highlightShader the one compiled with HIGHLIGHT
+    SpriteRenderer(Shader& shader, Shader& highlightShader);
     ~SpriteRenderer();
+    // while recording, DrawSprite appends to the command buffer instead of issuing GL calls
+    void Begin(CommandBuffer& commands);
+    void End();
+    CommandBuffer* Recording() const { return this->recording; }
     void DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), float alpha = 1.0f, bool isFlippedHorizontally = false, float threshold = 0.0f, glm::vec3 highlightColor = glm::vec3(1.0f, 0.0f, 0.0f));
+    void Execute(const SpriteCommand& command);
+    // draws count sprites with one buffer upload and one draw call per run of the same texture;
+    // runs without a highlight threshold use the plain shader variant
+    void DrawBatch(const SpriteCommand* sprites, size_t count);
 private:
-    Shader       shader;
-    unsigned int quadVAO;
+    struct Vertex {
+        glm::vec2 Position;
+        glm::vec2 TexCoords;
+        glm::vec4 Color;        // spriteColor, alpha
+        glm::vec4 Highlight;    // highlightColor, threshold
+    };
+    Shader         shader, highlightShader;
+    unsigned int   quadVAO, quadVBO, quadEBO;
+    CommandBuffer* recording = nullptr;
+    // reused between batches so a steady frame does not allocate
+    std::vector<float>         positionX, positionY, width, height, rotation;
+    std::vector<unsigned char> flip;
+    std::vector<glm::vec2>     corners;
+    std::vector<Vertex>        vertices;
     void initRenderData();
+    void drawChunk(const SpriteCommand* sprites, size_t count);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "sprite_transform.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "cpu_features.h"
+
+#if defined(CPU_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    constexpr float degreesToRadians = 0.0174532925199432958f;
+
+    // center c, rotated half axes a = R * (±w/2, 0) and b = R * (0, h/2)
+    inline void writeCorners(float cx, float cy, float ax, float ay, float bx, float by, float* out)
+    {
+        out[0] = cx - ax - bx; out[1] = cy - ay - by;
+        out[2] = cx + ax - bx; out[3] = cy + ay - by;
+        out[4] = cx + ax + bx; out[5] = cy + ay + by;
+        out[6] = cx - ax + bx; out[7] = cy - ay + by;
+    }
+
+    void transformScalar(const SpriteTransforms& sprites, size_t begin, float* out)
+    {
+        for (size_t i = begin; i < sprites.Count; ++i)
+        {
+            float c = 1.0f, s = 0.0f;
+            if (sprites.Rotation[i] != 0.0f)
+            {
+                const float radians = sprites.Rotation[i] * degreesToRadians;
+                c = std::cos(radians);
+                s = std::sin(radians);
+            }
+            const float hx = 0.5f * sprites.Width[i];
+            const float hy = 0.5f * sprites.Height[i];
+            const float fx = sprites.Flip[i] ? -hx : hx;
+            writeCorners(sprites.PositionX[i] + hx, sprites.PositionY[i] + hy,
+                c * fx, s * fx, -s * hy, c * hy, out + 8 * i);
+        }
+    }
+
+#if defined(CPU_X86_SIMD)
+    // Cephes single precision sin/cos: reduce to [-pi/4, pi/4] around the nearest multiple of
+    // pi/2, evaluate both polynomials and pick by quadrant
+    constexpr float twoOverPi = 0.636619772367581343f;
+    constexpr float halfPi1 = 1.5703125f;
+    constexpr float halfPi2 = 4.837512969970703125e-4f;
+    constexpr float halfPi3 = 7.54978995489188216e-8f;
+    constexpr float sin1 = -1.6666654611e-1f, sin2 = 8.3321608736e-3f, sin3 = -1.9515295891e-4f;
+    constexpr float cos1 = 4.166664568298827e-2f, cos2 = -1.388731625493765e-3f, cos3 = 2.443315711809948e-5f;
+
+    inline void sinCos4(__m128 x, __m128& sine, __m128& cosine)
+    {
+        const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(twoOverPi)));
+        const __m128 q = _mm_cvtepi32_ps(quadrant);
+        __m128 r = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(halfPi1)));
+        r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(halfPi2)));
+        r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(halfPi3)));
+        const __m128 z = _mm_mul_ps(r, r);
+
+        __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(sin3), z), _mm_set1_ps(sin2));
+        ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(sin1));
+        ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), r), r);
+        __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cos3), z), _mm_set1_ps(cos2));
+        pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(cos1));
+        pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+        pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i two = _mm_set1_epi32(2);
+        const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+        const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+        const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+        sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps)), sinSign);
+        cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc)), cosSign);
+    }
+
+    // all-ones lanes where the flip byte is set
+    inline __m128 flipMask4(const unsigned char* flip)
+    {
+        int packed;
+        std::memcpy(&packed, flip, sizeof(packed));
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lanes = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+        lanes = _mm_unpacklo_epi16(lanes, zero);
+        return _mm_castsi128_ps(_mm_cmpgt_epi32(lanes, zero));
+    }
+
+    // turns corner-major registers (one corner of four sprites each) into four sprites of xy pairs
+    inline void store4(__m128 x0, __m128 x1, __m128 x2, __m128 x3,
+                       __m128 y0, __m128 y1, __m128 y2, __m128 y3, float* out)
+    {
+        _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+        _MM_TRANSPOSE4_PS(y0, y1, y2, y3);
+        _mm_storeu_ps(out + 0, _mm_unpacklo_ps(x0, y0));
+        _mm_storeu_ps(out + 4, _mm_unpackhi_ps(x0, y0));
+        _mm_storeu_ps(out + 8, _mm_unpacklo_ps(x1, y1));
+        _mm_storeu_ps(out + 12, _mm_unpackhi_ps(x1, y1));
+        _mm_storeu_ps(out + 16, _mm_unpacklo_ps(x2, y2));
+        _mm_storeu_ps(out + 20, _mm_unpackhi_ps(x2, y2));
+        _mm_storeu_ps(out + 24, _mm_unpacklo_ps(x3, y3));
+        _mm_storeu_ps(out + 28, _mm_unpackhi_ps(x3, y3));
+    }
+
+    size_t transformSSE(const SpriteTransforms& sprites, float* out)
+    {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        size_t i = 0;
+        for (; i + 4 <= sprites.Count; i += 4)
+        {
+            const __m128 rotation = _mm_loadu_ps(sprites.Rotation + i);
+            __m128 s = _mm_setzero_ps();
+            __m128 c = _mm_set1_ps(1.0f);
+            // most sprites are not rotated, skip the polynomials for the whole group
+            if (_mm_movemask_ps(_mm_cmpneq_ps(rotation, _mm_setzero_ps())) != 0)
+                sinCos4(_mm_mul_ps(rotation, _mm_set1_ps(degreesToRadians)), s, c);
+
+            const __m128 hx = _mm_mul_ps(half, _mm_loadu_ps(sprites.Width + i));
+            const __m128 hy = _mm_mul_ps(half, _mm_loadu_ps(sprites.Height + i));
+            const __m128 fx = _mm_xor_ps(hx, _mm_and_ps(flipMask4(sprites.Flip + i), signBit));
+            const __m128 cx = _mm_add_ps(_mm_loadu_ps(sprites.PositionX + i), hx);
+            const __m128 cy = _mm_add_ps(_mm_loadu_ps(sprites.PositionY + i), hy);
+            const __m128 ax = _mm_mul_ps(c, fx);
+            const __m128 ay = _mm_mul_ps(s, fx);
+            const __m128 bx = _mm_xor_ps(_mm_mul_ps(s, hy), signBit);
+            const __m128 by = _mm_mul_ps(c, hy);
+
+            const __m128 lx = _mm_sub_ps(cx, ax), rx = _mm_add_ps(cx, ax);
+            const __m128 ly = _mm_sub_ps(cy, ay), ry = _mm_add_ps(cy, ay);
+            store4(_mm_sub_ps(lx, bx), _mm_sub_ps(rx, bx), _mm_add_ps(rx, bx), _mm_add_ps(lx, bx),
+                   _mm_sub_ps(ly, by), _mm_sub_ps(ry, by), _mm_add_ps(ry, by), _mm_add_ps(ly, by),
+                   out + 8 * i);
+        }
+        return i;
+    }
+
+    CPU_TARGET_AVX2 inline void sinCos8(__m256 x, __m256& sine, __m256& cosine)
+    {
+        const __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(twoOverPi)));
+        const __m256 q = _mm256_cvtepi32_ps(quadrant);
+        __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(halfPi1)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(q, _mm256_set1_ps(halfPi2)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(q, _mm256_set1_ps(halfPi3)));
+        const __m256 z = _mm256_mul_ps(r, r);
+
+        __m256 ps = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(sin3), z), _mm256_set1_ps(sin2));
+        ps = _mm256_add_ps(_mm256_mul_ps(ps, z), _mm256_set1_ps(sin1));
+        ps = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(ps, z), r), r);
+        __m256 pc = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(cos3), z), _mm256_set1_ps(cos2));
+        pc = _mm256_add_ps(_mm256_mul_ps(pc, z), _mm256_set1_ps(cos1));
+        pc = _mm256_mul_ps(_mm256_mul_ps(pc, z), z);
+        pc = _mm256_add_ps(_mm256_sub_ps(pc, _mm256_mul_ps(_mm256_set1_ps(0.5f), z)), _mm256_set1_ps(1.0f));
+
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i two = _mm256_set1_epi32(2);
+        const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+        const __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+        const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+        sine = _mm256_xor_ps(_mm256_blendv_ps(ps, pc, swap), sinSign);
+        cosine = _mm256_xor_ps(_mm256_blendv_ps(pc, ps, swap), cosSign);
+    }
+
+    CPU_TARGET_AVX2 size_t transformAVX2(const SpriteTransforms& sprites, float* out)
+    {
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+        size_t i = 0;
+        for (; i + 8 <= sprites.Count; i += 8)
+        {
+            const __m256 rotation = _mm256_loadu_ps(sprites.Rotation + i);
+            __m256 s = _mm256_setzero_ps();
+            __m256 c = _mm256_set1_ps(1.0f);
+            if (_mm256_movemask_ps(_mm256_cmp_ps(rotation, _mm256_setzero_ps(), _CMP_NEQ_UQ)) != 0)
+                sinCos8(_mm256_mul_ps(rotation, _mm256_set1_ps(degreesToRadians)), s, c);
+
+            const __m256i flip = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(sprites.Flip + i)));
+            const __m256 flipMask = _mm256_castsi256_ps(_mm256_cmpgt_epi32(flip, _mm256_setzero_si256()));
+
+            const __m256 hx = _mm256_mul_ps(half, _mm256_loadu_ps(sprites.Width + i));
+            const __m256 hy = _mm256_mul_ps(half, _mm256_loadu_ps(sprites.Height + i));
+            const __m256 fx = _mm256_xor_ps(hx, _mm256_and_ps(flipMask, signBit));
+            const __m256 cx = _mm256_add_ps(_mm256_loadu_ps(sprites.PositionX + i), hx);
+            const __m256 cy = _mm256_add_ps(_mm256_loadu_ps(sprites.PositionY + i), hy);
+            const __m256 ax = _mm256_mul_ps(c, fx);
+            const __m256 ay = _mm256_mul_ps(s, fx);
+            const __m256 bx = _mm256_xor_ps(_mm256_mul_ps(s, hy), signBit);
+            const __m256 by = _mm256_mul_ps(c, hy);
+
+            const __m256 lx = _mm256_sub_ps(cx, ax), rx = _mm256_add_ps(cx, ax);
+            const __m256 ly = _mm256_sub_ps(cy, ay), ry = _mm256_add_ps(cy, ay);
+            const __m256 x0 = _mm256_sub_ps(lx, bx), x1 = _mm256_sub_ps(rx, bx);
+            const __m256 x2 = _mm256_add_ps(rx, bx), x3 = _mm256_add_ps(lx, bx);
+            const __m256 y0 = _mm256_sub_ps(ly, by), y1 = _mm256_sub_ps(ry, by);
+            const __m256 y2 = _mm256_add_ps(ry, by), y3 = _mm256_add_ps(ly, by);
+            // interleaving is a 4x4 transpose per half
+            store4(_mm256_castps256_ps128(x0), _mm256_castps256_ps128(x1), _mm256_castps256_ps128(x2), _mm256_castps256_ps128(x3),
+                   _mm256_castps256_ps128(y0), _mm256_castps256_ps128(y1), _mm256_castps256_ps128(y2), _mm256_castps256_ps128(y3),
+                   out + 8 * i);
+            store4(_mm256_extractf128_ps(x0, 1), _mm256_extractf128_ps(x1, 1), _mm256_extractf128_ps(x2, 1), _mm256_extractf128_ps(x3, 1),
+                   _mm256_extractf128_ps(y0, 1), _mm256_extractf128_ps(y1, 1), _mm256_extractf128_ps(y2, 1), _mm256_extractf128_ps(y3, 1),
+                   out + 8 * (i + 4));
+        }
+        return i;
+    }
+#endif
+}
+
+TransformPath BestTransformPath()
+{
+    if (CpuFeatures::HasAVX2())
+        return TRANSFORM_AVX2;
+    if (CpuFeatures::HasSSE2())
+        return TRANSFORM_SSE;
+    return TRANSFORM_SCALAR;
+}
+
+void TransformSprites(const SpriteTransforms& sprites, glm::vec2* corners)
+{
+    static const TransformPath best = BestTransformPath();
+    TransformSprites(sprites, corners, best);
+}
+
+void TransformSprites(const SpriteTransforms& sprites, glm::vec2* corners, TransformPath path)
+{
+    float* out = reinterpret_cast<float*>(corners);
+    size_t done = 0;
+#if defined(CPU_X86_SIMD)
+    if (path == TRANSFORM_AVX2 && CpuFeatures::HasAVX2())
+        done = transformAVX2(sprites, out);
+    else if (path != TRANSFORM_SCALAR)
+        done = transformSSE(sprites, out);
+#endif
+    // remainder that does not fill a whole vector
+    transformScalar(sprites, done, out);
+}
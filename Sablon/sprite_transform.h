@@ -0,0 +1,33 @@
+#pragma once
+#ifndef SPRITE_TRANSFORM_H
+#define SPRITE_TRANSFORM_H
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// structure-of-arrays view of the sprites to transform, Count entries in every array
+struct SpriteTransforms {
+    const float*         PositionX;
+    const float*         PositionY;
+    const float*         Width;
+    const float*         Height;
+    const float*         Rotation;   // degrees around the sprite center, like GameObject::Rotation
+    const unsigned char* Flip;       // non-zero mirrors the sprite horizontally
+    size_t               Count;
+};
+
+enum TransformPath {
+    TRANSFORM_SCALAR,
+    TRANSFORM_SSE,
+    TRANSFORM_AVX2
+};
+
+// Writes four world-space corners per sprite into corners (4 * Count entries), in the order of
+// texture coordinates (0,0), (1,0), (1,1), (0,1). Equivalent to the model matrix SpriteRenderer
+// used to build with glm, but without any 4x4 math and without trig for unrotated sprites.
+void          TransformSprites(const SpriteTransforms& sprites, glm::vec2* corners);
+void          TransformSprites(const SpriteTransforms& sprites, glm::vec2* corners, TransformPath path);
+TransformPath BestTransformPath();
+
+#endif
@@ -0,0 +1,10 @@
+#version 330 core
+in float Brightness;
+out vec4 color;
+
+uniform sampler2D image;
+
+void main()
+{
+    color = vec4(1.0, 1.0, 1.0, Brightness) * texture(image, gl_PointCoord);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec4 star; // <vec2 position, float size, float phase>
+
+out float Brightness;
+
+// per-frame constants shared by every program, see FrameConstants in render_queue.h
+layout (std140) uniform FrameConstants
+{
+    mat4  projection;
+    mat4  view;
+    vec2  viewportSize;     // pixels
+    float time;             // seconds of game time
+    float sunAngle;         // degrees
+};
+
+uniform float visibility;
+
+void main()
+{
+    // every star twinkles at its own rate, derived from its phase
+    float twinkle = 0.7 + 0.3 * sin(time * (1.5 + 0.5 * star.w) + star.w);
+    Brightness = visibility * twinkle;
+    // sizes are in world units; the projection's y scale says how many pixels one is
+    gl_PointSize = star.z * 0.5 * viewportSize.y * abs(projection[1][1] * view[1][1]);
+    gl_Position = projection * view * vec4(star.xy, 0.0, 1.0);
+}
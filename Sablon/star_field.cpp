@@ -0,0 +1,113 @@
+#include "star_field.h"
+
+#include "memory_tracker.h"
+#include "job_system.h"
+
+StarField::StarField(Shader& shader, Texture2D& texture)
+    : uploaded(0), changed(false)
+{
+    MemoryScope scope(MEMORY_SCENE);
+    this->shader = shader;
+    this->texture = texture;
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(StarVertex), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+StarField::~StarField()
+{
+    glDeleteVertexArrays(1, &this->VAO);
+    glDeleteBuffers(1, &this->VBO);
+    MemoryTracker::UntrackBuffer(this->VBO);
+}
+
+void StarField::Begin(CommandBuffer& commands)
+{
+    this->recording = &commands;
+}
+
+void StarField::End()
+{
+    this->recording = nullptr;
+}
+
+void StarField::Generate(Random& random, size_t count, glm::vec2 min, glm::vec2 max, float minSize, float maxSize)
+{
+    MemoryScope scope(MEMORY_SCENE);
+    // every star takes four numbers, so a chunk starts its own copy of the generator that far in
+    constexpr size_t numbersPerStar = 4;
+    this->stars.resize(count);
+    JobSystem::ParallelFor(count, 4096, [&](size_t begin, size_t end)
+    {
+        Random chunk = random;
+        chunk.Advance(begin * numbersPerStar);
+        for (size_t i = begin; i < end; ++i)
+        {
+            StarVertex& star = this->stars[i];
+            const float x = chunk.Float(min.x, max.x);
+            const float y = chunk.Float(min.y, max.y);
+            star.Position = glm::vec2(x, y);
+            star.Size = chunk.Float(minSize, maxSize);
+            star.Phase = chunk.Float(0.0f, 6.2831853f);
+        }
+    });
+    random.Advance(count * numbersPerStar);
+    this->changed = true;
+}
+
+void StarField::SetStreamed(const std::vector<StarVertex>& stars)
+{
+    MemoryScope scope(MEMORY_SCENE);
+    this->streamed = stars;
+    this->changed = true;
+}
+
+void StarField::Draw(float visibility)
+{
+    const std::vector<StarVertex>* stars = &this->stars;
+    if (!this->streamed.empty())
+    {
+        if (this->changed)
+        {
+            MemoryScope scope(MEMORY_SCENE);
+            this->drawn.assign(this->stars.begin(), this->stars.end());
+            this->drawn.insert(this->drawn.end(), this->streamed.begin(), this->streamed.end());
+        }
+        stars = &this->drawn;
+    }
+    const StarCommand command = { this->changed ? stars->data() : nullptr, stars->size(), visibility };
+    this->changed = false;
+    if (this->recording)
+        this->recording->PushStars(command);
+    else
+        this->Execute(command);
+}
+
+void StarField::Execute(const StarCommand& command)
+{
+    if (command.Stars)
+    {
+        MemoryScope scope(MEMORY_SCENE);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+        glBufferData(GL_ARRAY_BUFFER, command.Count * sizeof(StarVertex), command.Stars, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        MemoryTracker::TrackBuffer(this->VBO, command.Count * sizeof(StarVertex), MEMORY_SCENE);
+        this->uploaded = command.Count;
+    }
+    if (command.Visibility <= 0.0f || this->uploaded == 0)
+        return;
+    this->shader.Use();
+    this->shader.SetFloat("visibility", command.Visibility);
+    glActiveTexture(GL_TEXTURE0);
+    this->texture.Bind();
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glBindVertexArray(this->VAO);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(this->uploaded));
+    glBindVertexArray(0);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+}
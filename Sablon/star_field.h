@@ -0,0 +1,46 @@
+#pragma once
+#ifndef STAR_FIELD_H
+#define STAR_FIELD_H
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+#include "Shader.h"
+#include "render_queue.h"
+#include "random.h"
+
+// All stars in one static vertex buffer drawn as textured points with a single draw call.
+// The buffer is only rewritten after Generate(); visibility and twinkle are uniforms, so a
+// frame costs the CPU the same for 50 stars as for 100k.
+class StarField
+{
+public:
+    StarField(Shader& shader, Texture2D& texture);
+    ~StarField();
+    // while recording, Draw appends to the command buffer instead of issuing GL calls
+    void Begin(CommandBuffer& commands);
+    void End();
+    // places count stars in [min, max]; they reach the GPU with the next drawn frame.
+    // The same generator state gives the same stars however many job threads there are.
+    void Generate(Random& random, size_t count, glm::vec2 min, glm::vec2 max, float minSize, float maxSize);
+    // stars drawn after the generated ones, such as those of streamed chunks
+    void SetStreamed(const std::vector<StarVertex>& stars);
+    // the twinkle runs on the frame constants' time
+    void Draw(float visibility);
+    void Execute(const StarCommand& command);
+private:
+    Shader                  shader;
+    Texture2D               texture;
+    unsigned int            VAO, VBO;
+    size_t                  uploaded;       // stars in the vertex buffer
+    std::vector<StarVertex> stars;
+    std::vector<StarVertex> streamed;
+    std::vector<StarVertex> drawn;          // stars then streamed, rebuilt when either changes
+    bool                    changed;
+    CommandBuffer*          recording = nullptr;
+};
+
+#endif
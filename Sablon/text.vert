@@ -2,10 +2,18 @@
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
 out vec2 TexCoords;
 
-uniform mat4 projection;
+// per-frame constants shared by every program, see FrameConstants in render_queue.h
+layout (std140) uniform FrameConstants
+{
+    mat4  projection;
+    mat4  view;
+    vec2  viewportSize;     // pixels
+    float time;             // seconds of game time
+    float sunAngle;         // degrees
+};
 
 void main()
 {
-    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    gl_Position = projection * view * vec4(vertex.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
 } 
\ No newline at end of file
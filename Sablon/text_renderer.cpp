@@ -1,3 +1,4 @@
+#include <cstring>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -6,14 +7,14 @@
 
 #include "text_renderer.h"
 #include "resource_manager.h"
+#include "memory_tracker.h"
 
 
-TextRenderer::TextRenderer(unsigned int width, unsigned int height)
+TextRenderer::TextRenderer()
 {
     // load and configure shader
     this->TextShader = ResourceManager::LoadShader("text.vert", "text.frag", nullptr, "text");
-    this->TextShader.SetMatrix4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f), true);
-    this->TextShader.SetInteger("text", 0);
+    this->TextShader.Use().SetInteger("text", 0);
     // configure VAO/VBO for texture quads
     glGenVertexArrays(1, &this->VAO);
     glGenBuffers(1, &this->VBO);
@@ -24,10 +25,12 @@ TextRenderer::TextRenderer(unsigned int width, unsigned int height)
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+    MemoryTracker::TrackBuffer(this->VBO, sizeof(float) * 6 * 4, MEMORY_TEXT);
 }
 
 void TextRenderer::Load(std::string font, unsigned int fontSize)
 {
+    MemoryScope scope(MEMORY_TEXT);
     this->Characters.clear();
     FT_Library ft;
     if (FT_Init_FreeType(&ft)) // all functions return a value different than 0 whenever an error occurred
@@ -62,6 +65,7 @@ void TextRenderer::Load(std::string font, unsigned int fontSize)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        MemoryTracker::TrackTexture(texture, face->glyph->bitmap.width, face->glyph->bitmap.rows, GL_RED, MEMORY_TEXT);
 
         Character character = {
             texture,
@@ -76,12 +80,36 @@ void TextRenderer::Load(std::string font, unsigned int fontSize)
     FT_Done_FreeType(ft);
 }
 
-void TextRenderer::RenderText(std::string text, float x, float y, float scale, glm::vec3 color, float alpha, float threshold)
+void TextRenderer::Begin(CommandBuffer& commands)
+{
+    this->recording = &commands;
+}
+
+void TextRenderer::End()
+{
+    this->recording = nullptr;
+}
+
+void TextRenderer::RenderText(const char* text, float x, float y, float scale, glm::vec3 color, float alpha, float threshold)
+{
+    const size_t length = std::strlen(text);
+    if (this->recording)
+        this->recording->PushText({ text, length, x, y, scale, color, alpha, threshold });
+    else
+        this->drawText(text, length, x, y, scale, color, alpha, threshold);
+}
+
+void TextRenderer::Execute(const TextCommand& command)
+{
+    this->drawText(command.Text, command.Length, command.X, command.Y, command.Scale, command.Color, command.Alpha, command.Threshold);
+}
+
+void TextRenderer::drawText(const char* text, size_t length, float x, float y, float scale, glm::vec3 color, float alpha, float threshold)
 {
     this->TextShader.Use();
     this->TextShader.SetVector3f("textColor", color);
 
-    int total_chars = text.size();
+    int total_chars = static_cast<int>(length);
     int threshold_index = static_cast<int>(threshold * total_chars);
 
     glActiveTexture(GL_TEXTURE0);
@@ -8,7 +8,8 @@
 #include <glm/glm.hpp>
 
 #include "texture.h"
-#include "shader.h"
+#include "Shader.h"
+#include "render_queue.h"
 
 
 struct Character {
@@ -24,11 +25,18 @@ class TextRenderer
 public:
     std::map<char, Character> Characters;
     Shader TextShader;
-    TextRenderer(unsigned int width, unsigned int height);
+    // text is placed in world space by the frame constants' projection, like sprites
+    TextRenderer();
     void Load(std::string font, unsigned int fontSize);
-    void RenderText(std::string text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f), float alpha = 1.0f, float threshold = 0.0f);
+    // while recording, RenderText appends to the command buffer instead of issuing GL calls
+    void Begin(CommandBuffer& commands);
+    void End();
+    void RenderText(const char* text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f), float alpha = 1.0f, float threshold = 0.0f);
+    void Execute(const TextCommand& command);
 private:
     unsigned int VAO, VBO;
+    CommandBuffer* recording = nullptr;
+    void drawText(const char* text, size_t length, float x, float y, float scale, glm::vec3 color, float alpha, float threshold);
 };
 
 #endif 
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <iostream>
 #include "texture.h"
+#include "memory_tracker.h"
 
 Texture2D::Texture2D()
     : Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR)
@@ -18,6 +19,7 @@ void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char*
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
     glBindTexture(GL_TEXTURE_2D, 0);
+    MemoryTracker::TrackTexture(this->ID, width, height, this->Internal_Format, MemoryTracker::CurrentTag());
 }
 
 void Texture2D::Bind() const
@@ -0,0 +1,22 @@
+#version 330 core
+in vec2 TexCoords;
+out vec4 color;
+
+uniform sampler2D image;
+uniform vec2 sourceSize;     // pixels of the texture that were drawn to, from its corner
+uniform vec2 textureSize;    // pixels of the whole texture
+uniform vec2 outputSize;     // pixels of the window
+
+void main()
+{
+    // sharp bilinear: every source pixel is a flat block on screen, only the pixels on the
+    // border between two blocks are blended, so edges stay crisp at any scale
+    vec2 texel = TexCoords * sourceSize;
+    vec2 scale = max(outputSize / sourceSize, vec2(1.0));
+    vec2 region = 0.5 - 0.5 / scale;
+    vec2 fromCenter = fract(texel) - 0.5;
+    vec2 offset = (fromCenter - clamp(fromCenter, -region, region)) * scale + 0.5;
+    // the rest of the texture holds older, larger frames, so never blend across the edge
+    vec2 sampled = clamp(floor(texel) + offset, vec2(0.5), sourceSize - 0.5);
+    color = texture(image, sampled / textureSize);
+}
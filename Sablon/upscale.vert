@@ -0,0 +1,10 @@
+#version 330 core
+layout (location = 0) in vec2 vertex; // clip-space corner of the screen quad
+
+out vec2 TexCoords;
+
+void main()
+{
+    TexCoords = vertex * 0.5 + 0.5;
+    gl_Position = vec4(vertex, 0.0, 1.0);
+}